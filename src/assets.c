@@ -0,0 +1,44 @@
+// ###########################################################################
+//          Title: YaGoL Asset Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Looks up the images that are embedded in the executable
+//                 at build time, falling back to the images/ directory.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include <SDL2/SDL_image.h>
+#include "assets.h"
+
+const Asset* findAsset(const char *name)
+{
+    // Only runs the first time each image is loaded, sprites are cached after that
+    for(int i = 0; i < embeddedAssetCount; i++)
+    {
+        if(strcmp(EmbeddedAssets[i].name, name) == 0)
+        {
+            return &EmbeddedAssets[i];
+        }
+    }
+
+    return NULL;
+}
+
+SDL_Surface* loadAssetSurface(const char *name)
+{
+    const Asset *asset = findAsset(name);
+
+    if(asset != NULL)
+    {
+        return IMG_Load_RW(SDL_RWFromConstMem(asset->data, asset->size), 1);
+    }
+
+    return IMG_Load(name);
+}
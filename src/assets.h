@@ -0,0 +1,36 @@
+// ###########################################################################
+//          Title: YaGoL Asset Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Looks up the images that are embedded in the executable
+//                 at build time, falling back to the images/ directory.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <SDL2/SDL.h>
+
+typedef struct ASSET_S
+{
+    const char *name; // Path relative to the repository, e.g. "images/ledRed.png"
+    const unsigned char *data;
+    unsigned int size;
+} Asset;
+
+// Generated by tools/bin2c.c into embedded.c
+extern const Asset EmbeddedAssets[];
+extern const int embeddedAssetCount;
+
+const Asset* findAsset(const char *name);
+SDL_Surface* loadAssetSurface(const char *name);
+
+#endif
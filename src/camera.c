@@ -0,0 +1,154 @@
+// ###########################################################################
+//          Title: YaGoL Camera Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Tracks the zoom and pan of the view over the grid and
+//                 converts between screen and cell coordinates.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include <math.h>
+#include "camera.h"
+#include "grid.h"
+
+Camera gCamera;
+
+void initCamera()
+{
+    gCamera.basePitch = 1;
+    gCamera.viewW = 0;
+    gCamera.viewH = 0;
+    resetCamera();
+}
+
+void resetCamera()
+{
+    gCamera.x = 0;
+    gCamera.y = 0;
+    gCamera.zoom = 1.0;
+}
+
+void setCameraView(int basePitch, int viewW, int viewH)
+{
+    gCamera.basePitch = basePitch > 0 ? basePitch : 1;
+    gCamera.viewW = viewW;
+    gCamera.viewH = viewH;
+}
+
+void zoomCamera(double factor, int anchorX, int anchorY)
+{
+    double oldPitch = cameraPitch();
+    double minZoom = MINCELLPITCH / gCamera.basePitch;
+
+    gCamera.zoom *= factor;
+
+    if(gCamera.zoom < minZoom)
+    {
+        gCamera.zoom = minZoom;
+    }
+
+    if(gCamera.zoom > MAXZOOM)
+    {
+        gCamera.zoom = MAXZOOM;
+    }
+
+    // Keep the cell under the anchor point in place while zooming
+    double newPitch = cameraPitch();
+    gCamera.x += anchorX / oldPitch - anchorX / newPitch;
+    gCamera.y += anchorY / oldPitch - anchorY / newPitch;
+}
+
+void panCamera(int dx, int dy)
+{
+    double pitch = cameraPitch();
+
+    gCamera.x -= dx / pitch;
+    gCamera.y -= dy / pitch;
+}
+
+void clampCamera()
+{
+    double pitch = cameraPitch();
+    double spanX = gCamera.viewW / pitch;
+    double spanY = gCamera.viewH / pitch;
+
+    // Pin the grid to the top left corner when it fits in the view,
+    // otherwise stop panning at the edges of the grid
+    if(gUniverse->w <= spanX || gCamera.x < 0)
+    {
+        gCamera.x = 0;
+    }
+    else if(gCamera.x > gUniverse->w - spanX)
+    {
+        gCamera.x = gUniverse->w - spanX;
+    }
+
+    if(gUniverse->h <= spanY || gCamera.y < 0)
+    {
+        gCamera.y = 0;
+    }
+    else if(gCamera.y > gUniverse->h - spanY)
+    {
+        gCamera.y = gUniverse->h - spanY;
+    }
+}
+
+double cameraPitch()
+{
+    return gCamera.basePitch * gCamera.zoom;
+}
+
+double cellScreenX(double x)
+{
+    return (x - gCamera.x) * cameraPitch();
+}
+
+double cellScreenY(double y)
+{
+    return (y - gCamera.y) * cameraPitch();
+}
+
+int screenToCell(int sx, int sy, int *cx, int *cy)
+{
+    if(sx < 0 || sy < 0 || sx >= gCamera.viewW || sy >= gCamera.viewH)
+    {
+        return 0;
+    }
+
+    double pitch = cameraPitch();
+    int x = (int)floor(gCamera.x + sx / pitch);
+    int y = (int)floor(gCamera.y + sy / pitch);
+
+    if(x < 0 || y < 0 || x >= gUniverse->w || y >= gUniverse->h)
+    {
+        return 0;
+    }
+
+    *cx = x;
+    *cy = y;
+
+    return 1;
+}
+
+void visibleCells(int *x0, int *y0, int *x1, int *y1)
+{
+    double pitch = cameraPitch();
+
+    // Half-open range [x0, x1) x [y0, y1) of cells that touch the view
+    *x0 = (int)floor(gCamera.x);
+    *y0 = (int)floor(gCamera.y);
+    *x1 = (int)ceil(gCamera.x + gCamera.viewW / pitch);
+    *y1 = (int)ceil(gCamera.y + gCamera.viewH / pitch);
+
+    if(*x0 < 0) *x0 = 0;
+    if(*y0 < 0) *y0 = 0;
+    if(*x1 > gUniverse->w) *x1 = gUniverse->w;
+    if(*y1 > gUniverse->h) *y1 = gUniverse->h;
+}
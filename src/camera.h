@@ -0,0 +1,47 @@
+// ###########################################################################
+//          Title: YaGoL Camera Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Tracks the zoom and pan of the view over the grid and
+//                 converts between screen and cell coordinates.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "graphics.h"
+
+#define MINCELLPITCH (1.0 / 16.0) // Farthest zoom, in screen pixels per cell
+#define MAXZOOM 4.0 // Closest zoom, relative to the native sprite size
+
+typedef struct CAMERA_S
+{
+    double x; // Cell column at the left edge of the view
+    double y; // Cell row at the top edge of the view
+    double zoom; // Scale relative to the native sprite size
+    int basePitch; // Cell pitch in pixels at a zoom of 1
+    int viewW; // Size of the board area of the window in pixels
+    int viewH;
+} Camera;
+
+void initCamera();
+void resetCamera();
+void setCameraView(int basePitch, int viewW, int viewH);
+void zoomCamera(double factor, int anchorX, int anchorY);
+void panCamera(int dx, int dy);
+void clampCamera();
+double cameraPitch();
+double cellScreenX(double x);
+double cellScreenY(double y);
+int screenToCell(int sx, int sy, int *cx, int *cy);
+void visibleCells(int *x0, int *y0, int *x1, int *y1);
+
+#endif
@@ -0,0 +1,866 @@
+// ###########################################################################
+//          Title: YaGoL Census Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Runs random soups until they settle down and counts the
+//                 still lifes, oscillators and spaceships they leave behind.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "census.h"
+#include "patterns.h"
+#include "workers.h"
+#include "trace.h"
+
+#include <signal.h>
+
+extern Engine *gEngine;
+
+volatile sig_atomic_t censusQuit = 0;
+Census censusNames = { NULL, 0, 0 }; // Codes of the library patterns, read only once the search starts
+
+void stopCensus(int signal)
+{
+    censusQuit = 1;
+}
+
+int runCensus(CensusConfig *config)
+{
+    Census census = { NULL, 0, 0 };
+
+    if(!initCensusNames())
+    {
+        freeCensus(&censusNames);
+        return 1;
+    }
+
+    SoupJob job;
+    job.config = config;
+    job.engine = gEngine;
+    job.census = &census;
+    job.lock = SDL_CreateMutex();
+
+    if(job.lock == NULL)
+    {
+        printf("Unable to create census lock: %s\n", SDL_GetError());
+        freeCensus(&censusNames);
+        return 1;
+    }
+
+    // Stop after the soups in flight, the census so far is still written
+    censusQuit = 0;
+    signal(SIGINT, stopCensus);
+    signal(SIGTERM, stopCensus);
+
+    // Hand out a few batches per thread at a time so progress can be reported
+    long batches = (config->soups + SOUPBATCH - 1) / SOUPBATCH;
+    long chunk = workerCount() * 4;
+    long searched = 0;
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 nextReport = start + frequency * CENSUSREPORT / 1000;
+
+    for(long batch = 0; batch < batches && !censusQuit; batch += chunk)
+    {
+        int items = (int)(batch + chunk < batches ? chunk : batches - batch);
+
+        job.first = batch * SOUPBATCH;
+        runWorkers(searchSoups, &job, items);
+
+        searched = (batch + items) * SOUPBATCH < config->soups ? (batch + items) * SOUPBATCH : config->soups;
+
+        if(SDL_GetPerformanceCounter() >= nextReport)
+        {
+            nextReport = SDL_GetPerformanceCounter() + frequency * CENSUSREPORT / 1000;
+            printf("%li soups, %.1f soups/s, %i distinct objects\n", searched,
+                   searched / ((double)(SDL_GetPerformanceCounter() - start) / frequency), census.used);
+        }
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+
+    printf("Searched %li %ix%i soups in %.3f s (%.1f soups/s), %i distinct objects\n", searched, SOUPSIZE, SOUPSIZE, seconds,
+           searched / seconds, census.used);
+
+    int result = !writeCensus(&census, config->filename, searched, config->seed, seconds);
+
+    SDL_DestroyMutex(job.lock);
+    freeCensus(&census);
+    freeCensus(&censusNames);
+
+    return result;
+}
+
+void searchSoups(void *data, int item)
+{
+    SoupJob *job = data;
+    long first = job->first + (long)item * SOUPBATCH;
+    long last = first + SOUPBATCH < job->config->soups ? first + SOUPBATCH : job->config->soups;
+
+    // Shapes repeat a lot from soup to soup, so each batch remembers what it already classified
+    Census counts = { NULL, 0, 0 };
+    Census cache = { NULL, 0, 0 };
+    Board *boards[4];
+    int *stack = malloc(sizeof(int) * SOUPBOARD * SOUPBOARD);
+    int ready = stack != NULL;
+
+    Uint64 traced = traceBegin();
+
+    for(int i = 0; i < 4; i++)
+    {
+        boards[i] = createBoard(SOUPBOARD, SOUPBOARD);
+        ready = ready && boards[i] != NULL;
+    }
+
+    for(long soup = first; soup < last && ready; soup++)
+    {
+        runSoup(job->engine, job->config->seed, soup, boards, stack, &counts, &cache);
+    }
+
+    if(ready)
+    {
+        SDL_LockMutex(job->lock);
+        ready = mergeCensus(job->census, &counts);
+        SDL_UnlockMutex(job->lock);
+    }
+
+    if(!ready)
+    {
+        printf("Unable to search soups %li to %li!\n", first, last - 1);
+    }
+
+    traceEnd("searchSoups", traced);
+
+    for(int i = 0; i < 4; i++)
+    {
+        freeBoard(boards[i]);
+    }
+
+    free(stack);
+    freeCensus(&counts);
+    freeCensus(&cache);
+}
+
+void runSoup(Engine *engine, Uint64 seed, long soup, Board *boards[4], int *stack, Census *counts, Census *cache)
+{
+    Board *current = boards[0];
+    Board *next = boards[1];
+    Board *phases = boards[2];
+    Board *visited = boards[3];
+    Uint64 hashes[MAXPERIOD];
+    int period = 0;
+
+    // Rows outside [low, high) of each board are known to be dead
+    int low = (SOUPBOARD - SOUPSIZE) / 2;
+    int high = low + SOUPSIZE;
+    int nextLow = 0;
+    int nextHigh = 0;
+
+    seedSoup(current, seed, soup);
+    clearBoard(next);
+
+    for(int gen = 0; gen < SOUPMAXGENS && period == 0; gen++)
+    {
+        // Spaceships leave before they reach the dead edge and are counted on the way out
+        if(gen > 0 && gen % SOUPEDGECHECK == 0 && !removeEscapees(engine, current, visited, stack, counts, cache))
+        {
+            addCensus(counts, "zz_edge", NULL, 1);
+            return;
+        }
+
+        // Settled once the board repeats, the hashes of the last few generations are enough to spot it
+        Uint64 hash = hashBoard(current, low, high);
+
+        for(int p = 1; p <= MAXPERIOD && p <= gen; p++)
+        {
+            if(hashes[(gen - p) % MAXPERIOD] == hash)
+            {
+                period = p;
+                break;
+            }
+        }
+
+        if(period == 0)
+        {
+            hashes[gen % MAXPERIOD] = hash;
+            stepSoup(engine, current, next, &low, &high, &nextLow, &nextHigh);
+
+            Board *swap = current;
+            current = next;
+            next = swap;
+        }
+    }
+
+    if(period == 0)
+    {
+        addCensus(counts, "zz_unstable", NULL, 1);
+        return;
+    }
+
+    // Objects are split using every cell they ever reach, so an oscillator never falls apart
+    copyBoard(phases, current);
+
+    for(int p = 1; p < period; p++)
+    {
+        stepBoardSerial(engine, current, next, SOUPBOARD, SOUPBOARD, 0);
+
+        Board *swap = current;
+        current = next;
+        next = swap;
+
+        for(size_t i = 0; i < (size_t)SOUPBOARD * phases->stride; i++)
+        {
+            phases->cells[i] |= current->cells[i];
+        }
+    }
+
+    clearBoard(visited);
+
+    int x = -1;
+    int y = 0;
+    char code[CENSUSCODELEN];
+    SDL_Rect box;
+
+    while(nextCell(phases, visited, 0, &x, &y))
+    {
+        Board *shape = findObject(phases, current, visited, stack, x, y, &box);
+        if(shape == NULL)
+        {
+            continue;
+        }
+
+        classifyObject(engine, shape, code, cache);
+        addCensus(counts, code, NULL, 1);
+        freeBoard(shape);
+    }
+}
+
+void seedSoup(Board *board, Uint64 seed, long soup)
+{
+    int x0 = (SOUPBOARD - SOUPSIZE) / 2;
+
+    clearBoard(board);
+
+    for(int y = 0; y < SOUPSIZE; y++)
+    {
+        Uint64 bits = seededWord(seed, (int)soup, y);
+
+        for(int x = 0; x < SOUPSIZE; x++)
+        {
+            setBoardCell(board, x0 + x, x0 + y, (int)(bits >> x) & 1);
+        }
+    }
+}
+
+void stepSoup(Engine *engine, Board *src, Board *dst, int *low, int *high, int *dstLow, int *dstHigh)
+{
+    // Only the rows around live cells can change, the rest of the board stays dead
+    int y0 = *low > 0 ? *low - 1 : 0;
+    int y1 = *high < src->h ? *high + 1 : src->h;
+
+    if(engine->stepRows == NULL)
+    {
+        stepReference(src, dst, src->w, src->h, 0);
+        y0 = 0;
+        y1 = src->h;
+    }
+    else if(y1 > y0)
+    {
+        engine->stepRows(src->cells, dst->cells, src->cells + (size_t)src->h * src->stride, src->stride, src->w, src->h, 0, y0, y1);
+    }
+
+    // Clear whatever the older generation left in dst outside the rows just stepped
+    for(int y = *dstLow; y < *dstHigh; y++)
+    {
+        if(y < y0 || y >= y1)
+        {
+            memset(&dst->cells[(size_t)y * dst->stride], 0, sizeof(Uint64) * dst->stride);
+        }
+    }
+
+    int newLow = y1;
+    int newHigh = y0;
+
+    for(int y = y0; y < y1; y++)
+    {
+        for(int word = 0; word < dst->stride; word++)
+        {
+            if(dst->cells[(size_t)y * dst->stride + word] != 0)
+            {
+                newLow = y < newLow ? y : newLow;
+                newHigh = y + 1;
+                break;
+            }
+        }
+    }
+
+    // The boards swap after each step, and so do their live rows
+    *dstLow = *low;
+    *dstHigh = *high;
+    *low = newLow < newHigh ? newLow : 0;
+    *high = newLow < newHigh ? newHigh : 0;
+}
+
+Uint64 hashBoard(Board *board, int y0, int y1)
+{
+    Uint64 hash = (Uint64)y0;
+
+    for(size_t i = (size_t)y0 * board->stride; i < (size_t)y1 * board->stride; i++)
+    {
+        hash = (hash ^ board->cells[i]) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 29;
+    }
+
+    return hash;
+}
+
+int nextCell(Board *board, Board *visited, int margin, int *x, int *y)
+{
+    // Carries on from the last cell found, only looking within margin of the edge if asked to
+    for(int row = *y; row < board->h; row++)
+    {
+        int start = row == *y ? *x + 1 : 0;
+        int inner = margin > 0 && row >= margin && row < board->h - margin;
+
+        for(int word = start >> 6; word < board->stride; word++)
+        {
+            Uint64 bits = BOARDWORD(board, word << 6, row) & ~BOARDWORD(visited, word << 6, row);
+
+            if(word == start >> 6)
+            {
+                bits &= ~(Uint64)0 << (start & 63);
+            }
+
+            if(inner)
+            {
+                int low = margin - (word << 6);
+                int high = board->w - margin - (word << 6);
+                Uint64 lowMask = low <= 0 ? 0 : low >= 64 ? ~(Uint64)0 : ((Uint64)1 << low) - 1;
+                Uint64 highMask = high <= 0 ? ~(Uint64)0 : high >= 64 ? 0 : ~(Uint64)0 << high;
+
+                bits &= lowMask | highMask;
+            }
+
+            if(bits != 0)
+            {
+                *x = (word << 6) + __builtin_ctzll(bits);
+                *y = row;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+Board* findObject(Board *cells, Board *phase, Board *visited, int *stack, int x, int y, SDL_Rect *box)
+{
+    int count = 0;
+    int minX = x, minY = y, maxX = x, maxY = y;
+
+    // Cells within two of each other belong together, anything further apart can never interact
+    stack[count++] = y * cells->w + x;
+    setBoardCell(visited, x, y, 1);
+
+    for(int i = 0; i < count; i++)
+    {
+        int cx = stack[i] % cells->w;
+        int cy = stack[i] / cells->w;
+
+        minX = cx < minX ? cx : minX;
+        maxX = cx > maxX ? cx : maxX;
+        minY = cy < minY ? cy : minY;
+        maxY = cy > maxY ? cy : maxY;
+
+        for(int ny = cy - 2; ny <= cy + 2; ny++)
+        {
+            for(int nx = cx - 2; nx <= cx + 2; nx++)
+            {
+                if(nx >= 0 && ny >= 0 && nx < cells->w && ny < cells->h && BOARDCELL(cells, nx, ny) && !BOARDCELL(visited, nx, ny))
+                {
+                    setBoardCell(visited, nx, ny, 1);
+                    stack[count++] = ny * cells->w + nx;
+                }
+            }
+        }
+    }
+
+    box->x = minX;
+    box->y = minY;
+    box->w = maxX - minX + 1;
+    box->h = maxY - minY + 1;
+
+    Board *shape = createBoard(box->w, box->h);
+    if(shape == NULL)
+    {
+        return NULL;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        int cx = stack[i] % cells->w;
+        int cy = stack[i] / cells->w;
+
+        if(BOARDCELL(phase, cx, cy))
+        {
+            setBoardCell(shape, cx - minX, cy - minY, 1);
+        }
+    }
+
+    return shape;
+}
+
+int removeEscapees(Engine *engine, Board *board, Board *visited, int *stack, Census *counts, Census *cache)
+{
+    int x = -1;
+    int y = 0;
+    char code[CENSUSCODELEN];
+    SDL_Rect box;
+
+    clearBoard(visited);
+
+    while(nextCell(board, visited, SOUPMARGIN, &x, &y))
+    {
+        Board *shape = findObject(board, board, visited, stack, x, y, &box);
+        if(shape == NULL)
+        {
+            return 0;
+        }
+
+        classifyObject(engine, shape, code, cache);
+
+        // Anything but a spaceship this close to the edge would soon be bent out of shape by it
+        if(strncmp(code, "xq", 2) != 0)
+        {
+            freeBoard(shape);
+            return 0;
+        }
+
+        addCensus(counts, code, NULL, 1);
+        blitBoard(board, box.x, box.y, board->w, board->h, shape, 0, 0, shape->w, shape->h, BLITCLEAR);
+        freeBoard(shape);
+    }
+
+    return 1;
+}
+
+void classifyObject(Engine *engine, Board *shape, char *code, Census *cache)
+{
+    char raw[CENSUSCODELEN];
+
+    if(shape->w > MAXOBJECTSIZE || shape->h > MAXOBJECTSIZE)
+    {
+        strcpy(code, "zz_large");
+        return;
+    }
+
+    encodeBoard(shape, raw);
+
+    CensusEntry *known = cache != NULL ? findCensus(cache, raw) : NULL;
+    if(known != NULL)
+    {
+        strcpy(code, known->value);
+        return;
+    }
+
+    // Step the object on its own with room to move until it comes back, perhaps somewhere else
+    int w = shape->w + 2 * ISOLATIONMARGIN;
+    int h = shape->h + 2 * ISOLATIONMARGIN;
+    Board *current = createBoard(w, h);
+    Board *next = createBoard(w, h);
+    Board *phases[MAXPERIOD + 1] = { NULL };
+    int period = 0;
+    int moved = 0;
+    int large = 0;
+    SDL_Rect start;
+    SDL_Rect box;
+
+    strcpy(code, "zz_unknown");
+
+    if(current != NULL && next != NULL)
+    {
+        blitBoard(current, ISOLATIONMARGIN, ISOLATIONMARGIN, w, h, shape, 0, 0, shape->w, shape->h, BLITCOPY);
+
+        if(boardBounds(current, &start))
+        {
+            phases[0] = cropBoard(current, &start);
+        }
+    }
+
+    for(int t = 1; t <= MAXPERIOD && phases[t - 1] != NULL; t++)
+    {
+        stepBoardSerial(engine, current, next, w, h, 0);
+
+        Board *swap = current;
+        current = next;
+        next = swap;
+
+        // Dying out or reaching the edge means this was not a finished object
+        if(!boardBounds(current, &box) || box.x == 0 || box.y == 0 || box.x + box.w == w || box.y + box.h == h)
+        {
+            break;
+        }
+
+        // Some phases of an object can be larger than the one it was found in
+        if(box.w > MAXOBJECTSIZE || box.h > MAXOBJECTSIZE)
+        {
+            large = 1;
+            break;
+        }
+
+        phases[t] = cropBoard(current, &box);
+
+        if(phases[t] != NULL && sameBoard(phases[t], phases[0]))
+        {
+            period = t;
+            moved = box.x != start.x || box.y != start.y;
+            break;
+        }
+    }
+
+    if(large)
+    {
+        strcpy(code, "zz_large");
+    }
+    else if(period > 0)
+    {
+        char body[CENSUSCODELEN] = "";
+        char candidate[CENSUSCODELEN];
+
+        // The canonical body is the smallest encoding of any phase in any of the eight orientations
+        for(int t = 0; t < period; t++)
+        {
+            for(int orientation = 0; orientation < ORIENTATIONS; orientation++)
+            {
+                Board *oriented = transformBoard(phases[t], phases[t]->w, phases[t]->h, orientation);
+                if(oriented == NULL)
+                {
+                    continue;
+                }
+
+                encodeBoard(oriented, candidate);
+                freeBoard(oriented);
+
+                if(body[0] == '\0' || strcmp(candidate, body) < 0)
+                {
+                    strcpy(body, candidate);
+                }
+            }
+        }
+
+        if(moved)
+        {
+            snprintf(code, CENSUSCODELEN, "xq%i_%s", period, body);
+        }
+        else if(period > 1)
+        {
+            snprintf(code, CENSUSCODELEN, "xp%i_%s", period, body);
+        }
+        else
+        {
+            snprintf(code, CENSUSCODELEN, "xs%li_%s", countBoardCells(phases[0], phases[0]->w, phases[0]->h), body);
+        }
+    }
+
+    for(int t = 0; t <= MAXPERIOD; t++)
+    {
+        freeBoard(phases[t]);
+    }
+
+    freeBoard(current);
+    freeBoard(next);
+
+    if(cache != NULL)
+    {
+        addCensus(cache, raw, code, 0);
+    }
+}
+
+int boardBounds(Board *board, SDL_Rect *box)
+{
+    int minX = board->w, minY = board->h, maxX = -1, maxY = -1;
+
+    for(int y = 0; y < board->h; y++)
+    {
+        for(int word = 0; word < board->stride; word++)
+        {
+            Uint64 bits = BOARDWORD(board, word << 6, y);
+
+            if(bits != 0)
+            {
+                int low = (word << 6) + __builtin_ctzll(bits);
+                int high = (word << 6) + 63 - __builtin_clzll(bits);
+
+                minX = low < minX ? low : minX;
+                maxX = high > maxX ? high : maxX;
+                minY = y < minY ? y : minY;
+                maxY = y;
+            }
+        }
+    }
+
+    if(maxY < 0)
+    {
+        return 0;
+    }
+
+    box->x = minX;
+    box->y = minY;
+    box->w = maxX - minX + 1;
+    box->h = maxY - minY + 1;
+
+    return 1;
+}
+
+Board* cropBoard(Board *board, SDL_Rect *box)
+{
+    Board *crop = createBoard(box->w, box->h);
+    if(crop == NULL)
+    {
+        return NULL;
+    }
+
+    blitBoard(crop, 0, 0, box->w, box->h, board, box->x, box->y, box->w, box->h, BLITCOPY);
+
+    return crop;
+}
+
+int sameBoard(Board *a, Board *b)
+{
+    return a->w == b->w && a->h == b->h && memcmp(a->cells, b->cells, sizeof(Uint64) * a->h * a->stride) == 0;
+}
+
+void encodeBoard(Board *board, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    // Width, height and then every row as hex digits, four cells to a digit starting from the left
+    out += sprintf(out, "%ix%i_", board->w, board->h);
+
+    for(int y = 0; y < board->h; y++)
+    {
+        for(int x = 0; x < board->w; x += 4)
+        {
+            *out++ = digits[(BOARDWORD(board, x, y) >> (x & 63)) & 15];
+        }
+    }
+
+    *out = '\0';
+}
+
+int initCensusNames()
+{
+    char code[CENSUSCODELEN];
+
+    // Objects the pattern library knows by name are named in the census too
+    for(int i = 0; i < patternCount; i++)
+    {
+        Board *cells = patternCells(&Patterns[i], 0);
+        if(cells == NULL)
+        {
+            continue;
+        }
+
+        classifyObject(gEngine, cells, code, NULL);
+
+        if(strncmp(code, "zz", 2) != 0 && findCensus(&censusNames, code) == NULL
+           && addCensus(&censusNames, code, Patterns[i].name, 0) == NULL)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+CensusEntry* findCensus(Census *census, const char *key)
+{
+    if(census->capacity == 0)
+    {
+        return NULL;
+    }
+
+    CensusEntry *entry = censusSlot(census, key);
+
+    return entry->key == NULL ? NULL : entry;
+}
+
+CensusEntry* censusSlot(Census *census, const char *key)
+{
+    // FNV-1a, then linear probing up to the entry or the empty slot it would go in
+    Uint64 hash = 0xCBF29CE484222325ULL;
+
+    for(const char *c = key; *c != '\0'; c++)
+    {
+        hash = (hash ^ (Uint8)*c) * 0x100000001B3ULL;
+    }
+
+    int i = (int)(hash & (census->capacity - 1));
+
+    while(census->entries[i].key != NULL && strcmp(census->entries[i].key, key) != 0)
+    {
+        i = (i + 1) & (census->capacity - 1);
+    }
+
+    return &census->entries[i];
+}
+
+CensusEntry* addCensus(Census *census, const char *key, const char *value, Uint64 count)
+{
+    CensusEntry *entry = findCensus(census, key);
+
+    if(entry != NULL)
+    {
+        entry->count += count;
+        return entry;
+    }
+
+    // Keep the table at most half full so probes stay short
+    if((census->used + 1) * 2 > census->capacity)
+    {
+        Census grown = { NULL, census->capacity == 0 ? 64 : census->capacity * 2, census->used };
+
+        grown.entries = calloc(grown.capacity, sizeof(CensusEntry));
+        if(grown.entries == NULL)
+        {
+            printf("Unable to grow census to %i entries!\n", grown.capacity);
+            return NULL;
+        }
+
+        for(int i = 0; i < census->capacity; i++)
+        {
+            if(census->entries[i].key != NULL)
+            {
+                *censusSlot(&grown, census->entries[i].key) = census->entries[i];
+            }
+        }
+
+        free(census->entries);
+        *census = grown;
+    }
+
+    entry = censusSlot(census, key);
+    entry->key = strdup(key);
+    entry->value = value != NULL ? strdup(value) : NULL;
+    entry->count = count;
+
+    if(entry->key == NULL || (value != NULL && entry->value == NULL))
+    {
+        printf("Unable to add %s to census!\n", key);
+        free(entry->key);
+        free(entry->value);
+        entry->key = NULL;
+        entry->value = NULL;
+        return NULL;
+    }
+
+    census->used++;
+
+    return entry;
+}
+
+int mergeCensus(Census *dst, Census *src)
+{
+    for(int i = 0; i < src->capacity; i++)
+    {
+        CensusEntry *entry = &src->entries[i];
+
+        if(entry->key != NULL && addCensus(dst, entry->key, entry->value, entry->count) == NULL)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int compareCensus(const void *a, const void *b)
+{
+    const CensusEntry *x = *(CensusEntry * const *)a;
+    const CensusEntry *y = *(CensusEntry * const *)b;
+
+    // Most common first, ties in code order so runs are easy to diff
+    if(x->count != y->count)
+    {
+        return x->count < y->count ? 1 : -1;
+    }
+
+    return strcmp(x->key, y->key);
+}
+
+int writeCensus(Census *census, char *filename, long soups, Uint64 seed, double seconds)
+{
+    CensusEntry **sorted = malloc(sizeof(CensusEntry*) * (census->used + 1));
+    if(sorted == NULL)
+    {
+        printf("Unable to sort census!\n");
+        return 0;
+    }
+
+    int count = 0;
+
+    for(int i = 0; i < census->capacity; i++)
+    {
+        if(census->entries[i].key != NULL)
+        {
+            sorted[count++] = &census->entries[i];
+        }
+    }
+
+    qsort(sorted, count, sizeof(CensusEntry*), compareCensus);
+
+    FILE *file = fopen(filename, "w");
+    if(file == NULL)
+    {
+        printf("Unable to write census %s!\n", filename);
+        free(sorted);
+        return 0;
+    }
+
+    fprintf(file, "# YaGoL census of %li %ix%i soups, seed %llu\n", soups, SOUPSIZE, SOUPSIZE, (unsigned long long)seed);
+    fprintf(file, "# %.3f s, %.1f soups/s\n", seconds, seconds > 0 ? soups / seconds : 0);
+
+    for(int i = 0; i < count; i++)
+    {
+        CensusEntry *name = findCensus(&censusNames, sorted[i]->key);
+
+        fprintf(file, "%llu %s%s%s\n", (unsigned long long)sorted[i]->count, sorted[i]->key, name != NULL ? " " : "",
+                name != NULL ? name->value : "");
+    }
+
+    int written = fclose(file) == 0;
+    if(!written)
+    {
+        printf("Unable to write census %s!\n", filename);
+    }
+    else
+    {
+        printf("Census of %i objects written to %s\n", count, filename);
+    }
+
+    free(sorted);
+
+    return written;
+}
+
+void freeCensus(Census *census)
+{
+    for(int i = 0; i < census->capacity; i++)
+    {
+        free(census->entries[i].key);
+        free(census->entries[i].value);
+    }
+
+    free(census->entries);
+    census->entries = NULL;
+    census->capacity = 0;
+    census->used = 0;
+}
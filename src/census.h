@@ -0,0 +1,89 @@
+// ###########################################################################
+//          Title: YaGoL Census Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Runs random soups until they settle down and counts the
+//                 still lifes, oscillators and spaceships they leave behind.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef CENSUS_H
+#define CENSUS_H
+
+#include "engine.h"
+
+#define SOUPSIZE 16 // Width and height of a soup in cells
+#define SOUPBOARD 256 // Soups are stepped in the middle of a board this size, with dead edges
+#define SOUPMARGIN 16 // Objects this close to the edge are checked for escaping spaceships
+#define SOUPEDGECHECK 16 // Generations between checks, short enough that a c/2 ship cannot cross the margin
+#define SOUPMAXGENS 20000 // Soups still changing after this many generations are given up on
+#define SOUPBATCH 64 // Soups handed to a worker at a time
+#define MAXPERIOD 60 // Longest period of a settled soup or object that is recognised
+#define MAXOBJECTSIZE 64 // Objects with a larger bounding box are not classified
+#define ISOLATIONMARGIN (MAXPERIOD / 2 + 2) // Room for a spaceship to move while its period is found
+#define CENSUSCODELEN 1100 // Fits the code of any phase up to MAXOBJECTSIZE square, larger objects are zz_large
+#define CENSUSREPORT 5000 // How often progress is printed (ms)
+
+typedef struct CENSUSCONFIG_S
+{
+    long soups;
+    Uint64 seed; // Soup n is filled from seededWord(seed, n, row)
+    char *filename; // Census written here when done
+} CensusConfig;
+
+typedef struct CENSUSENTRY_S
+{
+    char *key; // NULL for an empty slot
+    char *value;
+    Uint64 count;
+} CensusEntry;
+
+// String keyed hash table, used for object counts, names and already classified shapes
+typedef struct CENSUS_S
+{
+    CensusEntry *entries;
+    int capacity; // Always a power of 2
+    int used;
+} Census;
+
+typedef struct SOUPJOB_S
+{
+    CensusConfig *config;
+    Engine *engine;
+    long first; // First soup of the first batch
+    Census *census; // Counts of every batch are merged in here
+    SDL_mutex *lock;
+} SoupJob;
+
+int runCensus(CensusConfig *config);
+void searchSoups(void *data, int item);
+void stopCensus(int signal);
+void runSoup(Engine *engine, Uint64 seed, long soup, Board *boards[4], int *stack, Census *counts, Census *cache);
+void seedSoup(Board *board, Uint64 seed, long soup);
+void stepSoup(Engine *engine, Board *src, Board *dst, int *low, int *high, int *dstLow, int *dstHigh);
+Uint64 hashBoard(Board *board, int y0, int y1);
+int nextCell(Board *board, Board *visited, int margin, int *x, int *y);
+Board* findObject(Board *cells, Board *phase, Board *visited, int *stack, int x, int y, SDL_Rect *box);
+int removeEscapees(Engine *engine, Board *board, Board *visited, int *stack, Census *counts, Census *cache);
+void classifyObject(Engine *engine, Board *shape, char *code, Census *cache);
+int boardBounds(Board *board, SDL_Rect *box);
+Board* cropBoard(Board *board, SDL_Rect *box);
+int sameBoard(Board *a, Board *b);
+void encodeBoard(Board *board, char *out);
+int initCensusNames();
+CensusEntry* findCensus(Census *census, const char *key);
+CensusEntry* censusSlot(Census *census, const char *key);
+CensusEntry* addCensus(Census *census, const char *key, const char *value, Uint64 count);
+int mergeCensus(Census *dst, Census *src);
+int compareCensus(const void *a, const void *b);
+int writeCensus(Census *census, char *filename, long soups, Uint64 seed, double seconds);
+void freeCensus(Census *census);
+
+#endif
@@ -0,0 +1,440 @@
+// ###########################################################################
+//          Title: YaGoL Checkpoint Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Writes packed copies of a universe to disk on a background
+//                 thread while it keeps stepping, keeping the last few.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "checkpoint.h"
+#include "trace.h"
+
+CheckpointConfig checkpointConfig;
+SDL_Thread *checkpointThread = NULL;
+SDL_mutex *checkpointLock = NULL;
+SDL_cond *checkpointWake = NULL; // Signalled when a board is handed over
+SDL_cond *checkpointIdle = NULL; // Signalled when a board has been written
+Board *checkpointBoard = NULL; // Board being written, the caller must not change it until it is released
+CheckpointHeader checkpointHeader;
+int checkpointQuit = 0;
+
+// Written by the checkpoint thread only
+char checkpointNames[MAXCHECKPOINTS][CHECKPOINTNAMELEN];
+int checkpointCount = 0;
+
+// Used by the stepping thread only
+Uint64 lastGeneration = 0;
+Uint64 lastTime = 0;
+
+int checkpointMain(void *data)
+{
+    traceThreadName("checkpoint");
+
+    SDL_LockMutex(checkpointLock);
+    while(!checkpointQuit || checkpointBoard != NULL)
+    {
+        if(checkpointBoard == NULL)
+        {
+            SDL_CondWait(checkpointWake, checkpointLock);
+            continue;
+        }
+
+        Board *board = checkpointBoard;
+        CheckpointHeader header = checkpointHeader;
+        SDL_UnlockMutex(checkpointLock);
+
+        char *name = checkpointNames[checkpointCount % MAXCHECKPOINTS];
+        snprintf(name, CHECKPOINTNAMELEN, "%s-%09llu.ckpt", checkpointConfig.prefix, (unsigned long long)header.generation);
+
+        Uint64 trace = traceBegin();
+        int written = writeCheckpoint(name, board, &header);
+        traceEnd("writeCheckpoint", trace);
+
+        // Only the newest few written by this process are kept, files left by earlier runs are not touched
+        if(written && ++checkpointCount > checkpointConfig.keep)
+        {
+            remove(checkpointNames[(checkpointCount - checkpointConfig.keep - 1) % MAXCHECKPOINTS]);
+        }
+
+        SDL_LockMutex(checkpointLock);
+        checkpointBoard = NULL;
+        SDL_CondBroadcast(checkpointIdle);
+    }
+    SDL_UnlockMutex(checkpointLock);
+
+    return 0;
+}
+
+int initCheckpoints(CheckpointConfig *config, Uint64 generation)
+{
+    checkpointConfig = *config;
+    checkpointQuit = 0;
+    checkpointCount = 0;
+    lastGeneration = generation; // The first checkpoint is counted from where the universe starts
+
+    if(checkpointConfig.prefix == NULL)
+    {
+        return 1;
+    }
+
+    if(checkpointConfig.keep < 1 || checkpointConfig.keep >= MAXCHECKPOINTS)
+    {
+        checkpointConfig.keep = checkpointConfig.keep < 1 ? 1 : MAXCHECKPOINTS - 1;
+    }
+
+    checkpointLock = SDL_CreateMutex();
+    checkpointWake = SDL_CreateCond();
+    checkpointIdle = SDL_CreateCond();
+    if(checkpointLock == NULL || checkpointWake == NULL || checkpointIdle == NULL)
+    {
+        printf("Unable to create checkpoint locks! SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    checkpointThread = SDL_CreateThread(checkpointMain, "checkpoint", NULL);
+    if(checkpointThread == NULL)
+    {
+        printf("Unable to create checkpoint thread! SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    lastTime = SDL_GetPerformanceCounter();
+
+    return 1;
+}
+
+int checkpointDue(Uint64 generation)
+{
+    if(checkpointThread == NULL || generation == lastGeneration)
+    {
+        return 0;
+    }
+
+    Uint64 seconds = (SDL_GetPerformanceCounter() - lastTime) / SDL_GetPerformanceFrequency();
+
+    return (checkpointConfig.every > 0 && generation - lastGeneration >= (Uint64)checkpointConfig.every)
+        || (checkpointConfig.seconds > 0 && seconds >= (Uint64)checkpointConfig.seconds);
+}
+
+int takeCheckpoint(Board *board, int w, int h, int wrap, Uint64 generation)
+{
+    int taken = 0;
+
+    SDL_LockMutex(checkpointLock);
+
+    // This generation is already on disk
+    if(generation == lastGeneration)
+    {
+        taken = 1;
+    }
+    // Unless the last one is still being written, then the caller tries again next generation
+    else if(checkpointBoard == NULL)
+    {
+        memset(&checkpointHeader, 0, sizeof(CheckpointHeader));
+        memcpy(checkpointHeader.magic, CHECKPOINTMAGIC, 8);
+        checkpointHeader.w = w;
+        checkpointHeader.h = h;
+        checkpointHeader.wrap = wrap;
+        checkpointHeader.generation = generation;
+
+        checkpointBoard = board;
+        SDL_CondSignal(checkpointWake);
+
+        lastGeneration = generation;
+        lastTime = SDL_GetPerformanceCounter();
+        taken = 1;
+    }
+
+    SDL_UnlockMutex(checkpointLock);
+
+    return taken;
+}
+
+int checkpointHolds(Board *board)
+{
+    if(checkpointThread == NULL)
+    {
+        return 0;
+    }
+
+    SDL_LockMutex(checkpointLock);
+    int holds = checkpointBoard == board;
+    SDL_UnlockMutex(checkpointLock);
+
+    return holds;
+}
+
+void waitCheckpoint()
+{
+    if(checkpointThread == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(checkpointLock);
+    while(checkpointBoard != NULL)
+    {
+        SDL_CondWait(checkpointIdle, checkpointLock);
+    }
+    SDL_UnlockMutex(checkpointLock);
+}
+
+int writeCheckpoint(char *filename, Board *board, CheckpointHeader *header)
+{
+    char temp[CHECKPOINTNAMELEN + 4];
+    int words = (header->w + 63) / 64;
+    Uint8 *packed = malloc((size_t)words * 10);
+
+    // Written under another name first, so a checkpoint on disk is always complete
+    snprintf(temp, sizeof(temp), "%s.tmp", filename);
+
+    FILE *file = fopen(temp, "wb");
+    if(file == NULL || packed == NULL)
+    {
+        printf("Unable to write checkpoint %s!\n", filename);
+        free(packed);
+        if(file != NULL)
+        {
+            fclose(file);
+        }
+        return 0;
+    }
+
+    int ok = fwrite(header, sizeof(CheckpointHeader), 1, file) == 1;
+
+    for(int y = 0; y < header->h && ok; y++)
+    {
+        size_t size = packWords(board->cells + (size_t)y * board->stride, words, packed);
+        ok = fwrite(packed, 1, size, file) == size;
+    }
+
+    ok = fclose(file) == 0 && ok;
+    free(packed);
+
+    if(!ok || rename(temp, filename) != 0)
+    {
+        printf("Unable to write checkpoint %s!\n", filename);
+        remove(temp);
+        return 0;
+    }
+
+    return 1;
+}
+
+Board* readCheckpoint(char *filename, CheckpointHeader *header)
+{
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        printf("Unable to read checkpoint %s!\n", filename);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    Uint8 *data = size > (long)sizeof(CheckpointHeader) ? malloc((size_t)size) : NULL;
+    Board *board = NULL;
+
+    if(data != NULL && fread(data, 1, (size_t)size, file) == (size_t)size)
+    {
+        memcpy(header, data, sizeof(CheckpointHeader));
+
+        if(memcmp(header->magic, CHECKPOINTMAGIC, 8) == 0 && header->w > 0 && header->h > 0)
+        {
+            board = createBoard(header->w, header->h);
+        }
+    }
+
+    size_t pos = sizeof(CheckpointHeader);
+
+    for(int y = 0; board != NULL && y < header->h; y++)
+    {
+        if(!unpackWords(data, (size_t)size, &pos, board->cells + (size_t)y * board->stride, (header->w + 63) / 64))
+        {
+            freeBoard(board);
+            board = NULL;
+        }
+    }
+
+    if(board == NULL)
+    {
+        printf("%s is not a checkpoint!\n", filename);
+    }
+
+    free(data);
+    fclose(file);
+
+    return board;
+}
+
+Uint8 byteTag(Uint64 word)
+{
+    Uint8 tag = 0;
+
+    // Bit b is set when byte b of the word is not zero
+    for(int b = 0; b < 8; b++)
+    {
+        if((word >> (b * 8)) & 0xFF)
+        {
+            tag |= 1 << b;
+        }
+    }
+
+    return tag;
+}
+
+size_t packWords(const Uint64 *words, int count, Uint8 *out)
+{
+    size_t size = 0;
+
+    // Each word is a tag byte marking its non-zero bytes, followed by those
+    // bytes. A zero word is followed by the number of zero words after it,
+    // and a full word by the number of nearly full words after it, stored
+    // whole. Mostly dead universes shrink several times, dense ones barely grow.
+    for(int i = 0; i < count; i++)
+    {
+        Uint64 word = words[i];
+        Uint8 tag = byteTag(word);
+
+        out[size++] = tag;
+
+        if(tag == 0)
+        {
+            int run = 0;
+
+            while(run < 255 && i + 1 < count && words[i + 1] == 0)
+            {
+                run++;
+                i++;
+            }
+
+            out[size++] = (Uint8)run;
+            continue;
+        }
+
+        for(int b = 0; b < 8; b++)
+        {
+            if(tag & (1 << b))
+            {
+                out[size++] = (Uint8)(word >> (b * 8));
+            }
+        }
+
+        if(tag == 0xFF)
+        {
+            int run = 0;
+            size_t countAt = size++;
+
+            // Words with at most one zero byte are cheaper whole than tagged
+            while(run < 255 && i + 1 < count && __builtin_popcount(byteTag(words[i + 1])) >= 7)
+            {
+                memcpy(out + size, &words[i + 1], sizeof(Uint64));
+                size += sizeof(Uint64);
+                run++;
+                i++;
+            }
+
+            out[countAt] = (Uint8)run;
+        }
+    }
+
+    return size;
+}
+
+int unpackWords(const Uint8 *in, size_t size, size_t *pos, Uint64 *words, int count)
+{
+    size_t at = *pos;
+
+    for(int i = 0; i < count; i++)
+    {
+        if(at >= size)
+        {
+            return 0;
+        }
+
+        Uint8 tag = in[at++];
+        Uint64 word = 0;
+
+        for(int b = 0; b < 8; b++)
+        {
+            if(tag & (1 << b))
+            {
+                if(at >= size)
+                {
+                    return 0;
+                }
+
+                word |= (Uint64)in[at++] << (b * 8);
+            }
+        }
+
+        words[i] = word;
+
+        if(tag == 0 || tag == 0xFF)
+        {
+            if(at >= size || i + in[at] >= count)
+            {
+                return 0;
+            }
+
+            int run = in[at++];
+
+            for(int r = 0; r < run; r++)
+            {
+                i++;
+
+                if(tag == 0)
+                {
+                    words[i] = 0;
+                }
+                else
+                {
+                    if(at + sizeof(Uint64) > size)
+                    {
+                        return 0;
+                    }
+
+                    memcpy(&words[i], in + at, sizeof(Uint64));
+                    at += sizeof(Uint64);
+                }
+            }
+        }
+    }
+
+    *pos = at;
+    return 1;
+}
+
+void closeCheckpoints()
+{
+    if(checkpointThread == NULL)
+    {
+        return;
+    }
+
+    // Any checkpoint being written is finished first
+    SDL_LockMutex(checkpointLock);
+    checkpointQuit = 1;
+    SDL_CondSignal(checkpointWake);
+    SDL_UnlockMutex(checkpointLock);
+
+    SDL_WaitThread(checkpointThread, NULL);
+    checkpointThread = NULL;
+
+    SDL_DestroyCond(checkpointIdle);
+    SDL_DestroyCond(checkpointWake);
+    SDL_DestroyMutex(checkpointLock);
+    checkpointIdle = NULL;
+    checkpointWake = NULL;
+    checkpointLock = NULL;
+}
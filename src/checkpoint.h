@@ -0,0 +1,57 @@
+// ###########################################################################
+//          Title: YaGoL Checkpoint Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Writes packed copies of a universe to disk on a background
+//                 thread while it keeps stepping, keeping the last few.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "engine.h"
+
+#define MAXCHECKPOINTS 64
+#define CHECKPOINTNAMELEN 256
+#define CHECKPOINTMAGIC "YAGOLCP1"
+
+typedef struct CHECKPOINTCONFIG_S
+{
+    char *prefix; // Checkpoints are written to PREFIX-GENERATION.ckpt, NULL for none
+    int every; // Generations between checkpoints, 0 for no limit
+    int seconds; // Seconds between checkpoints, 0 for no limit
+    int keep; // Newest checkpoints of this run kept on disk, older ones are deleted
+} CheckpointConfig;
+
+// Followed by each row packed with packWords
+typedef struct CHECKPOINTHEADER_S
+{
+    char magic[8];
+    Sint32 w;
+    Sint32 h;
+    Sint32 wrap;
+    Sint32 unused;
+    Uint64 generation;
+} CheckpointHeader;
+
+int initCheckpoints(CheckpointConfig *config, Uint64 generation);
+int checkpointDue(Uint64 generation);
+int takeCheckpoint(Board *board, int w, int h, int wrap, Uint64 generation);
+int checkpointHolds(Board *board);
+void waitCheckpoint();
+int writeCheckpoint(char *filename, Board *board, CheckpointHeader *header);
+Board* readCheckpoint(char *filename, CheckpointHeader *header);
+Uint8 byteTag(Uint64 word);
+size_t packWords(const Uint64 *words, int count, Uint8 *out);
+int unpackWords(const Uint8 *in, size_t size, size_t *pos, Uint64 *words, int count);
+void closeCheckpoints();
+
+#endif
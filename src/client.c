@@ -0,0 +1,238 @@
+// ###########################################################################
+//          Title: YaGoL Client Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Shows a universe stepped by a server (see server.h)
+//                 instead of stepping the grid locally.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "client.h"
+#include "grid.h"
+#include "hud.h"
+
+int gClientMode = 0; // Set when the grid shows a universe stepped by a server
+int gRemoteWidth = 0; // Size of the server's universe
+int gRemoteHeight = 0;
+
+int clientFd = -1;
+int remoteStride = 0;
+int remoteGeneration = -1; // Generation of the last delta applied
+char *clientBuffer = NULL; // Received bytes not yet parsed into messages
+size_t clientBuffered = 0;
+size_t clientCapacity = 0;
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <sys/socket.h>
+
+int initClient(char *address)
+{
+    char host[NETHOSTLEN];
+    int port;
+    Uint32 type, size;
+
+    if(!initNet() || !netParseAddress(address, host, NETHOSTLEN, &port))
+    {
+        printf("Bad server address %s!\n", address);
+        return 0;
+    }
+
+    clientFd = netConnect(host, port);
+    if(clientFd < 0)
+    {
+        return 0;
+    }
+
+    UniverseInfo *info = netRecvMessage(clientFd, &type, &size);
+    if(info == NULL || type != MSGUNIVERSE || size != sizeof(UniverseInfo))
+    {
+        printf("%s is not a YaGoL server!\n", address);
+        free(info);
+        closeClient();
+        return 0;
+    }
+
+    gRemoteWidth = info->w;
+    gRemoteHeight = info->h;
+    remoteStride = info->stride;
+    free(info);
+
+    clientCapacity = CLIENTBUFFER;
+    clientBuffer = malloc(clientCapacity);
+    if(clientBuffer == NULL)
+    {
+        closeClient();
+        return 0;
+    }
+
+    netSetNonBlocking(clientFd, 1);
+
+    // The first delta from the server is against an empty universe
+    gClientMode = 1;
+    clearBoard(gUniverse->current);
+    resizeGrid();
+
+    printf("Viewing a %ix%i universe from %s\n", gRemoteWidth, gRemoteHeight, address);
+
+    return 1;
+}
+
+int pollClient()
+{
+    int applied = 0;
+
+    if(clientFd < 0)
+    {
+        return 0;
+    }
+
+    while(1)
+    {
+        if(clientBuffered == clientCapacity)
+        {
+            char *grown = realloc(clientBuffer, clientCapacity * 2);
+            if(grown == NULL)
+            {
+                break;
+            }
+            clientBuffer = grown;
+            clientCapacity *= 2;
+        }
+
+        ssize_t got = recv(clientFd, clientBuffer + clientBuffered, clientCapacity - clientBuffered, 0);
+
+        if(got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            // Keep showing the last generation received
+            printf("Lost connection to the server!\n");
+            netClose(clientFd);
+            clientFd = -1;
+            break;
+        }
+
+        if(got < 0)
+        {
+            break;
+        }
+
+        clientBuffered += got;
+    }
+
+    // Apply every complete message, a partial one waits for the rest of its bytes
+    size_t used = 0;
+
+    while(clientBuffered - used >= sizeof(NetHeader))
+    {
+        NetHeader *header = (NetHeader*)(clientBuffer + used);
+
+        // Same limit as netRecvMessage, a larger size means the stream is broken
+        if(header->size > MAXMESSAGE)
+        {
+            printf("Bad message from the server, %u bytes!\n", header->size);
+            netClose(clientFd);
+            clientFd = -1;
+            clientBuffered = 0;
+            return applied;
+        }
+
+        if(clientBuffered - used < sizeof(NetHeader) + header->size)
+        {
+            break;
+        }
+
+        if(header->type == MSGDELTA)
+        {
+            applyDelta((char*)(header + 1), header->size);
+            applied++;
+        }
+
+        used += sizeof(NetHeader) + header->size;
+    }
+
+    memmove(clientBuffer, clientBuffer + used, clientBuffered - used);
+    clientBuffered -= used;
+
+    return applied;
+}
+
+void closeClient()
+{
+    netClose(clientFd);
+    clientFd = -1;
+    free(clientBuffer);
+    clientBuffer = NULL;
+    clientBuffered = 0;
+    clientCapacity = 0;
+}
+
+#else
+
+int initClient(char *address)
+{
+    printf("Client mode is not supported on this platform!\n");
+    return 0;
+}
+
+int pollClient()
+{
+    return 0;
+}
+
+void closeClient()
+{
+}
+
+#endif
+
+void applyDelta(char *data, Uint32 size)
+{
+    DeltaHead *head = (DeltaHead*)data;
+    char *p = (char*)(head + 1);
+    char *end = data + size;
+    size_t word = 0;
+
+    if(size < sizeof(DeltaHead))
+    {
+        return;
+    }
+
+    while(end - p >= 2 * (long)sizeof(Uint32))
+    {
+        Uint32 *record = (Uint32*)p;
+        Uint64 *changed = (Uint64*)(record + 2);
+
+        if((size_t)(end - (char*)changed) < record[1] * sizeof(Uint64))
+        {
+            break;
+        }
+
+        word += record[0];
+
+        for(Uint32 i = 0; i < record[1]; i++, word++)
+        {
+            size_t row = word / remoteStride;
+            size_t col = word % remoteStride;
+
+            // Parts of the universe bigger than the local grid are not shown
+            if(row < (size_t)gUniverse->current->h && col < (size_t)gUniverse->current->stride)
+            {
+                gUniverse->current->cells[row * gUniverse->current->stride + col] ^= changed[i];
+            }
+        }
+
+        p = (char*)(changed + record[1]);
+    }
+
+    remoteGeneration = head->generation;
+    gUniverse->version++;
+    hudAddGeneration();
+}
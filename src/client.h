@@ -0,0 +1,29 @@
+// ###########################################################################
+//          Title: YaGoL Client Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Shows a universe stepped by a server (see server.h)
+//                 instead of stepping the grid locally.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include "server.h"
+
+#define CLIENTBUFFER (64 * 1024) // Starting size of the receive buffer
+
+int initClient(char *address);
+int pollClient();
+void applyDelta(char *data, Uint32 size);
+void closeClient();
+
+#endif
@@ -0,0 +1,173 @@
+// ###########################################################################
+//          Title: YaGoL Commands Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Queue of edits from the user interface, applied to the
+//                 universes in order between generations.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "commands.h"
+
+CommandQueue commandQueue;
+
+int pushCommand(Command *command)
+{
+    Uint32 head = (Uint32)SDL_AtomicGet(&commandQueue.head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&commandQueue.tail);
+
+    // Never wait on the consumer, an edit that does not fit is dropped
+    if(head - tail >= COMMANDSLOTS)
+    {
+        printf("Command queue is full, dropping an edit!\n");
+        return 0;
+    }
+
+    commandQueue.slots[head & (COMMANDSLOTS - 1)] = *command;
+
+    // The command is written before the consumer can see it
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&commandQueue.head, (int)(head + 1));
+
+    return 1;
+}
+
+int queueCommand(Universe *universe, int kind, int value)
+{
+    Command command = { 0 };
+    command.kind = kind;
+    command.universe = universe;
+    command.value = value;
+
+    return pushCommand(&command);
+}
+
+int queuePaint(Universe *universe, int x0, int y0, int x1, int y1, int alive)
+{
+    Command command = { 0 };
+    command.kind = CMDPAINT;
+    command.universe = universe;
+    command.x0 = x0;
+    command.y0 = y0;
+    command.x1 = x1;
+    command.y1 = y1;
+    command.value = alive;
+
+    return pushCommand(&command);
+}
+
+int queueStamp(Universe *universe, Pattern *pattern, int orientation, int x, int y)
+{
+    Command command = { 0 };
+    command.kind = CMDSTAMP;
+    command.universe = universe;
+    command.x0 = x;
+    command.y0 = y;
+    command.pattern = pattern;
+    command.value = orientation;
+
+    return pushCommand(&command);
+}
+
+int queueRegion(Universe *universe, int kind, SDL_Rect *region, int value)
+{
+    // Nothing is selected
+    if(region->w <= 0 || region->h <= 0)
+    {
+        return 0;
+    }
+
+    Command command = { 0 };
+    command.kind = kind;
+    command.universe = universe;
+    command.region = *region;
+    command.value = value;
+
+    return pushCommand(&command);
+}
+
+int pendingCommands()
+{
+    return SDL_AtomicGet(&commandQueue.head) != SDL_AtomicGet(&commandQueue.tail);
+}
+
+int applyCommands()
+{
+    Uint32 tail = (Uint32)SDL_AtomicGet(&commandQueue.tail);
+    Uint32 head = (Uint32)SDL_AtomicGet(&commandQueue.head);
+
+    if(head == tail)
+    {
+        return 0;
+    }
+
+    // Everything queued so far goes in as one batch
+    SDL_MemoryBarrierAcquire();
+
+    for(Uint32 i = tail; i != head; i++)
+    {
+        applyCommand(&commandQueue.slots[i & (COMMANDSLOTS - 1)]);
+    }
+
+    // The slots are done with before the producer can reuse them
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&commandQueue.tail, (int)head);
+
+    return (int)(head - tail);
+}
+
+void applyCommand(Command *command)
+{
+    // Edits act on the universe that was focused when they were queued,
+    // which may no longer be the focused one
+    Universe *universe = command->universe;
+    int value = command->value;
+
+    // Resolve values that depend on the cells as they are now
+    if(command->kind == CMDPAINT && value == PAINTTOGGLE)
+    {
+        universe->stroke = !getCell(universe, command->x0, command->y0);
+        value = universe->stroke;
+    }
+    else if(command->kind == CMDPAINT && value == PAINTSTROKE)
+    {
+        value = universe->stroke;
+    }
+    else if(command->kind == CMDCOLOR && value == COLORNEXT)
+    {
+        value = universe->color == RANDOMCELL ? REDCELL : universe->color + 1;
+    }
+
+    switch(command->kind)
+    {
+        case CMDPAINT: paintLine(universe, command->x0, command->y0, command->x1, command->y1, value);
+            break;
+        case CMDJOURNAL: journalUniverse(universe);
+            break;
+        case CMDCLEAR: clearCells(universe);
+            break;
+        case CMDRANDOM: randomizeUniverse(universe);
+            break;
+        case CMDSTAMP: stampCells(universe, command->pattern, value, command->x0, command->y0);
+            break;
+        case CMDFILL: fillRegion(universe, &command->region, value);
+            break;
+        case CMDTRANSFORM: transformRegion(universe, &command->region, value);
+            break;
+        case CMDCOLOR: setGridColor(universe, value);
+            break;
+        case CMDSTEP: updateGrid(universe);
+            break;
+        case CMDUNDO: undoEdit(universe);
+            break;
+        case CMDREDO: redoEdit(universe);
+            break;
+    }
+}
@@ -0,0 +1,76 @@
+// ###########################################################################
+//          Title: YaGoL Commands Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Queue of edits from the user interface, applied to the
+//                 universes in order between generations.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include "grid.h"
+
+#define COMMANDSLOTS 4096 // Commands waiting to be applied, must be a power of two
+
+// Values resolved against the universe when the command is applied, since
+// edits queued before it may not have been applied yet when it is queued
+#define PAINTTOGGLE -1 // CMDPAINT: toggle the first cell, starting a stroke that sets that state
+#define PAINTSTROKE -2 // CMDPAINT: set the state of the stroke started by PAINTTOGGLE
+#define COLORNEXT -1 // CMDCOLOR: the color after the current one
+
+enum COMMANDKIND
+{
+    CMDPAINT = 0, // Set the cells on the line from (x0, y0) to (x1, y1) to value, or see PAINTTOGGLE
+    CMDJOURNAL = 1, // Close the undo entry of the edits so far
+    CMDCLEAR = 2,
+    CMDRANDOM = 3,
+    CMDSTAMP = 4, // Stamp pattern turned by value with its top left at (x0, y0)
+    CMDFILL = 5, // Fill region with value percent of live cells
+    CMDTRANSFORM = 6, // Turn region by orientation value
+    CMDCOLOR = 7, // Color value, or COLORNEXT
+    CMDSTEP = 8,
+    CMDUNDO = 9,
+    CMDREDO = 10
+};
+
+typedef struct COMMAND_S
+{
+    int kind;
+    Universe *universe; // Universe that was focused when the command was queued
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+    SDL_Rect region;
+    Pattern *pattern;
+    int value;
+} Command;
+
+// Single producer (the user interface) and single consumer (whatever steps
+// the universes), each side only ever writes its own index
+typedef struct COMMANDQUEUE_S
+{
+    Command slots[COMMANDSLOTS];
+    SDL_atomic_t head; // Next slot to be queued
+    SDL_atomic_t tail; // Next slot to be applied
+} CommandQueue;
+
+int pushCommand(Command *command);
+int queueCommand(Universe *universe, int kind, int value);
+int queuePaint(Universe *universe, int x0, int y0, int x1, int y1, int alive);
+int queueStamp(Universe *universe, Pattern *pattern, int orientation, int x, int y);
+int queueRegion(Universe *universe, int kind, SDL_Rect *region, int value);
+int pendingCommands();
+int applyCommands();
+void applyCommand(Command *command);
+
+#endif
@@ -0,0 +1,281 @@
+// ###########################################################################
+//          Title: YaGoL Conformance Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Steps known patterns and random soups with every engine
+//                 next to the reference stepper and reports where they
+//                 first disagree.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "conformance.h"
+#include "workers.h"
+#include "grid.h"
+
+extern int gActiveThreads;
+
+ConfPattern ConfPatterns[] =
+{
+    { "glider", { ".O.", "..O", "OOO", NULL } },
+    { "r-pentomino", { ".OO", "OO.", ".O.", NULL } },
+    { "acorn", { ".O.....", "...O...", "OO..OOO", NULL } },
+    { "gosper gun", {
+        "........................O...........",
+        "......................O.O...........",
+        "............OO......OO............OO",
+        "...........O...O....OO............OO",
+        "OO........O.....O...OO..............",
+        "OO........O...O.OO....O.O...........",
+        "..........O.....O.......O...........",
+        "...........O...O....................",
+        "............OO......................",
+        NULL } },
+};
+
+// Region sizes straddle the 64 cell word boundaries on purpose
+int patternSizes[][2] = { { 40, 30 }, { 64, 48 }, { 100, 80 } };
+int soupSizes[][2] = { { 1, 1 }, { 3, 2 }, { 7, 5 }, { 63, 17 }, { 64, 64 }, { 65, 33 }, { 128, 9 }, { 130, 70 }, { 257, 129 } };
+int soupDensities[] = { 5, 30, 50, 80 };
+
+int runConformance()
+{
+    int threadCounts[] = { 1, 2, 3, SDL_GetCPUCount() };
+    int patternCount = sizeof(ConfPatterns) / sizeof(ConfPatterns[0]);
+    int failures = 0;
+    int checks = 0;
+
+    for(int t = 0; t < (int)(sizeof(threadCounts) / sizeof(threadCounts[0])); t++)
+    {
+        closeWorkers();
+        initWorkers(threadCounts[t]);
+
+        for(int e = 0; e < engineCount; e++)
+        {
+            Engine *engine = &Engines[e];
+
+            // The reference is what everything else is checked against
+            if(engine->stepRows == NULL || !engine->available)
+            {
+                continue;
+            }
+
+            printf("Checking %s engine on %i threads\n", engine->name, workerCount());
+
+            for(int wrap = 0; wrap <= 1; wrap++)
+            {
+                for(int s = 0; s < (int)(sizeof(patternSizes) / sizeof(patternSizes[0])); s++)
+                {
+                    int w = patternSizes[s][0];
+                    int h = patternSizes[s][1];
+
+                    for(int p = 0; p < patternCount; p++)
+                    {
+                        Board *start = createBoard(w + BOARDMARGINX, h + BOARDMARGINY);
+                        checks++;
+                        if(start == NULL)
+                        {
+                            printf("FAIL: unable to allocate a %ix%i board\n", w + BOARDMARGINX, h + BOARDMARGINY);
+                            failures++;
+                            continue;
+                        }
+
+                        // Live cells all around the region catch engines that read or write past its edges
+                        randomizeBoard(start, s * 31 + p);
+                        placePattern(start, &ConfPatterns[p], w, h);
+
+                        failures += checkEngine(engine, ConfPatterns[p].name, start, w, h, wrap, PATTERNGENS);
+                        freeBoard(start);
+                    }
+                }
+
+                for(int s = 0; s < (int)(sizeof(soupSizes) / sizeof(soupSizes[0])); s++)
+                {
+                    int w = soupSizes[s][0];
+                    int h = soupSizes[s][1];
+
+                    for(int d = 0; d < (int)(sizeof(soupDensities) / sizeof(soupDensities[0])); d++)
+                    {
+                        Board *start = createBoard(w + BOARDMARGINX, h + BOARDMARGINY);
+                        checks++;
+                        if(start == NULL)
+                        {
+                            printf("FAIL: unable to allocate a %ix%i board\n", w + BOARDMARGINX, h + BOARDMARGINY);
+                            failures++;
+                            continue;
+                        }
+
+                        char name[32];
+                        snprintf(name, sizeof(name), "%i%% soup", soupDensities[d]);
+
+                        randomizeBoard(start, s * 31 + d);
+                        fillSoup(start, w, h, soupDensities[d], (Uint64)(t * 1000 + s * 10 + d + 1));
+
+                        failures += checkEngine(engine, name, start, w, h, wrap, SOUPGENS);
+                        freeBoard(start);
+                    }
+                }
+            }
+
+            // Several universes in one batch with their pixels built per band, as the window steps them
+            failures += checkFusedRender(engine);
+            checks++;
+
+            if(workerCount() > 1)
+            {
+                failures += checkThreads(engine);
+                checks++;
+            }
+        }
+    }
+
+    printf("%i of %i conformance checks passed\n", checks - failures, checks);
+
+    return failures > 0;
+}
+
+int checkEngine(Engine *engine, char *name, Board *start, int w, int h, int wrap, int generations)
+{
+    Board *expect[2];
+    Board *got[2];
+    int failed = 0;
+
+    expect[0] = createBoard(start->w, start->h);
+    expect[1] = createBoard(start->w, start->h);
+    got[0] = createBoard(start->w, start->h);
+    got[1] = createBoard(start->w, start->h);
+
+    if(expect[0] == NULL || expect[1] == NULL || got[0] == NULL || got[1] == NULL)
+    {
+        failed = 1;
+    }
+    else
+    {
+        // Both buffers start out identical, as the grid keeps them
+        copyBoard(expect[0], start);
+        copyBoard(expect[1], start);
+        copyBoard(got[0], start);
+        copyBoard(got[1], start);
+    }
+
+    for(int gen = 1; gen <= generations && !failed; gen++)
+    {
+        Board *refNext = expect[gen & 1];
+        Board *engineNext = got[gen & 1];
+
+        stepReference(expect[(gen - 1) & 1], refNext, w, h, wrap);
+        stepBoard(engine, got[(gen - 1) & 1], engineNext, w, h, wrap);
+
+        // Compare the whole board, cells outside the region must be left alone too
+        for(int y = 0; y < start->h && !failed; y++)
+        {
+            for(int x = 0; x < start->w; x++)
+            {
+                int want = BOARDCELL(refNext, x, y);
+
+                if(BOARDCELL(engineNext, x, y) != want)
+                {
+                    printf("FAIL: %s engine, %s, %ix%i region, %s edges, %i threads: generation %i, cell (%i,%i) should be %s\n",
+                           engine->name, name, w, h, wrap ? "wrapped" : "dead", workerCount(), gen, x, y, want ? "alive" : "dead");
+                    failed = 1;
+                    break;
+                }
+            }
+        }
+    }
+
+    freeBoard(expect[0]);
+    freeBoard(expect[1]);
+    freeBoard(got[0]);
+    freeBoard(got[1]);
+
+    return failed;
+}
+
+int checkThreads(Engine *engine)
+{
+    // Workers may wake too late to join a small job, so keep stepping until one does
+    Board *boards[2];
+    int joined = 0;
+
+    boards[0] = createBoard(BENCHSIZE, BENCHSIZE);
+    boards[1] = createBoard(BENCHSIZE, BENCHSIZE);
+
+    if(boards[0] != NULL && boards[1] != NULL)
+    {
+        randomizeBoard(boards[0], 1);
+
+        for(int gen = 0; gen < THREADGENS && !joined; gen++)
+        {
+            stepBoard(engine, boards[gen & 1], boards[(gen + 1) & 1], BENCHSIZE, BENCHSIZE, 1);
+            joined = gActiveThreads > 1;
+        }
+    }
+
+    if(!joined)
+    {
+        printf("FAIL: %s engine, %i threads were started but every band was stepped on one\n", engine->name, workerCount());
+    }
+
+    freeBoard(boards[0]);
+    freeBoard(boards[1]);
+
+    return !joined;
+}
+
+void placePattern(Board *board, ConfPattern *pattern, int w, int h)
+{
+    int rows = 0;
+    int cols = (int)strlen(pattern->rows[0]);
+
+    while(pattern->rows[rows] != NULL)
+    {
+        rows++;
+    }
+
+    // Patterns go in the middle of a dead region
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            setBoardCell(board, x, y, 0);
+        }
+    }
+
+    int x0 = (w - cols) / 2;
+    int y0 = (h - rows) / 2;
+
+    for(int y = 0; y < rows; y++)
+    {
+        for(int x = 0; x < cols; x++)
+        {
+            if(pattern->rows[y][x] == 'O' && x0 + x >= 0 && y0 + y >= 0 && x0 + x < w && y0 + y < h)
+            {
+                setBoardCell(board, x0 + x, y0 + y, 1);
+            }
+        }
+    }
+}
+
+void fillSoup(Board *board, int w, int h, int density, Uint64 seed)
+{
+    Uint64 state = seed * 0x9E3779B97F4A7C15ull + 1;
+
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+
+            setBoardCell(board, x, y, (int)(state % 100) < density);
+        }
+    }
+}
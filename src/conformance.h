@@ -0,0 +1,41 @@
+// ###########################################################################
+//          Title: YaGoL Conformance Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Steps known patterns and random soups with every engine
+//                 next to the reference stepper and reports where they
+//                 first disagree.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef CONFORMANCE_H
+#define CONFORMANCE_H
+
+#include "engine.h"
+
+#define PATTERNGENS 300 // Generations each known pattern is stepped
+#define SOUPGENS 40 // Generations each random soup is stepped
+#define BOARDMARGINX 70 // Extra cells right of the region, filled with junk that must survive
+#define BOARDMARGINY 3 // Extra rows below the region
+#define THREADGENS 100 // Generations stepped waiting for a worker thread to join
+
+typedef struct CONFPATTERN_S
+{
+    char *name;
+    char *rows[10]; // 'O' is a live cell, terminated by NULL
+} ConfPattern;
+
+int runConformance();
+int checkEngine(Engine *engine, char *name, Board *start, int w, int h, int wrap, int generations);
+int checkThreads(Engine *engine);
+void placePattern(Board *board, ConfPattern *pattern, int w, int h);
+void fillSoup(Board *board, int w, int h, int density, Uint64 seed);
+
+#endif
@@ -0,0 +1,784 @@
+// ###########################################################################
+//          Title: YaGoL Distributed Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Splits a universe into blocks stepped by separate worker
+//                 processes, which swap one cell halo strips with their
+//                 neighbors every generation. A coordinator hands out the
+//                 blocks and gathers statistics and snapshots.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "distributed.h"
+#include "workers.h"
+#include "trace.h"
+
+extern Engine *gEngine;
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+// Worker processes started by --spawn, so they can be stopped if the run fails
+static pid_t spawned[MAXBLOCKS];
+static int spawnedCount = 0;
+
+static void reapWorkers(int terminate)
+{
+    for(int i = 0; i < spawnedCount; i++)
+    {
+        if(terminate)
+        {
+            kill(spawned[i], SIGTERM);
+        }
+
+        while(waitpid(spawned[i], NULL, 0) < 0 && errno == EINTR);
+    }
+
+    spawnedCount = 0;
+}
+
+int runCoordinator(DistConfig *config)
+{
+    int count = config->blocksX * config->blocksY;
+    int fds[MAXBLOCKS];
+    char hosts[MAXBLOCKS][NETHOSTLEN];
+    int ports[MAXBLOCKS];
+    void *held[MAXBLOCKS] = { NULL };
+    Sint64 *population = NULL;
+    int *reported = NULL;
+    Uint32 *slowestStep = NULL;
+    Uint32 *slowestExchange = NULL;
+    Board *universe = NULL;
+    int result = 1;
+
+    if(count < 1 || count > MAXBLOCKS || config->w < config->blocksX || config->h < config->blocksY)
+    {
+        printf("Unable to split a %ix%i universe into %ix%i blocks!\n", config->w, config->h, config->blocksX, config->blocksY);
+        return 1;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        fds[i] = -1;
+    }
+
+    int listenFd = netListen(config->port, NULL);
+    if(listenFd < 0)
+    {
+        return 1;
+    }
+
+    printf("Coordinator waiting for %i workers on port %i\n", count, config->port);
+
+    if(config->spawn && !spawnWorkers(config, count))
+    {
+        goto done;
+    }
+
+    // Blocks are handed out in the order the workers connect
+    for(int i = 0; i < count; i++)
+    {
+        Uint32 type, size;
+
+        fds[i] = netAccept(listenFd, hosts[i], NETHOSTLEN);
+        DistHello *hello = fds[i] < 0 ? NULL : netRecvMessage(fds[i], &type, &size);
+
+        if(hello == NULL || type != MSGHELLO || size != sizeof(DistHello))
+        {
+            printf("Worker %i did not say hello!\n", i);
+            free(hello);
+            goto done;
+        }
+
+        if(hello->abi != DISTABI)
+        {
+            printf("Worker %i was built for a different platform!\n", i);
+            free(hello);
+            goto done;
+        }
+
+        ports[i] = hello->port;
+        free(hello);
+    }
+
+    netClose(listenFd);
+    listenFd = -1;
+
+    for(int i = 0; i < count; i++)
+    {
+        int bx = i % config->blocksX;
+        int by = i / config->blocksX;
+        int east = (by * config->blocksX) + (bx + 1) % config->blocksX;
+        int south = ((by + 1) % config->blocksY) * config->blocksX + bx;
+        DistAssign assign;
+
+        memset(&assign, 0, sizeof(assign));
+        assign.rank = i;
+        assign.x = (int)((Sint64)config->w * bx / config->blocksX);
+        assign.y = (int)((Sint64)config->h * by / config->blocksY);
+        assign.w = (int)((Sint64)config->w * (bx + 1) / config->blocksX) - assign.x;
+        assign.h = (int)((Sint64)config->h * (by + 1) / config->blocksY) - assign.y;
+        assign.generations = config->generations;
+        assign.snapshotEvery = config->snapshotFile != NULL ? config->snapshotEvery : 0;
+        assign.sendLast = config->snapshotFile != NULL || config->verify;
+        assign.seed = config->seed;
+        assign.hasLink[LINKWEST] = bx > 0 || config->wrap;
+        assign.hasLink[LINKEAST] = bx < config->blocksX - 1 || config->wrap;
+        assign.hasLink[LINKNORTH] = by > 0 || config->wrap;
+        assign.hasLink[LINKSOUTH] = by < config->blocksY - 1 || config->wrap;
+        snprintf(assign.eastHost, NETHOSTLEN, "%s", hosts[east]);
+        assign.eastPort = ports[east];
+        snprintf(assign.southHost, NETHOSTLEN, "%s", hosts[south]);
+        assign.southPort = ports[south];
+
+        if(!netSendMessage(fds[i], MSGASSIGN, &assign, sizeof(assign)))
+        {
+            printf("Unable to assign a block to worker %i!\n", i);
+            goto done;
+        }
+    }
+
+    // Per generation totals, filled in as the workers report
+    population = calloc(config->generations + 1, sizeof(Sint64));
+    reported = calloc(config->generations + 1, sizeof(int));
+    slowestStep = calloc(config->generations + 1, sizeof(Uint32));
+    slowestExchange = calloc(config->generations + 1, sizeof(Uint32));
+    universe = config->snapshotFile != NULL || config->verify ? createBoard(config->w, config->h) : NULL;
+
+    if(population == NULL || reported == NULL || slowestStep == NULL || slowestExchange == NULL
+    || ((config->snapshotFile != NULL || config->verify) && universe == NULL))
+    {
+        printf("Unable to allocate coordinator state!\n");
+        goto done;
+    }
+
+    // A worker that reports a block for a later snapshot is not read from again
+    // until the current snapshot is complete, so snapshots never mix generations
+    int done = 0;
+    int failed = 0;
+    int blocksIn = 0;
+    int snapshotGen = config->snapshotFile != NULL && config->snapshotEvery > 0 && config->snapshotEvery < config->generations
+                    ? config->snapshotEvery : config->generations;
+    int reportEvery = config->generations >= 10 ? config->generations / 10 : 1;
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    while(done < count && !failed)
+    {
+        struct pollfd polls[MAXBLOCKS];
+        int ranks[MAXBLOCKS];
+        int polled = 0;
+
+        for(int i = 0; i < count; i++)
+        {
+            if(fds[i] >= 0 && held[i] == NULL)
+            {
+                polls[polled].fd = fds[i];
+                polls[polled].events = POLLIN;
+                ranks[polled++] = i;
+            }
+        }
+
+        if(poll(polls, polled, -1) < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        for(int p = 0; p < polled; p++)
+        {
+            if(!(polls[p].revents & (POLLIN | POLLHUP | POLLERR)))
+            {
+                continue;
+            }
+
+            int i = ranks[p];
+            Uint32 type, size;
+            char *message = netRecvMessage(fds[i], &type, &size);
+
+            if(message == NULL)
+            {
+                printf("Lost connection to worker %i!\n", i);
+                failed = 1;
+                break;
+            }
+
+            if(type == MSGSTATS && size == sizeof(DistStats))
+            {
+                DistStats *stats = (DistStats*)message;
+                int gen = stats->generation;
+
+                if(gen >= 1 && gen <= config->generations)
+                {
+                    population[gen] += stats->population;
+                    slowestStep[gen] = SDL_max(slowestStep[gen], stats->stepMicros);
+                    slowestExchange[gen] = SDL_max(slowestExchange[gen], stats->exchangeMicros);
+
+                    if(++reported[gen] == count && (gen % reportEvery == 0 || gen == config->generations))
+                    {
+                        printf("Generation %i: population %li, slowest step %.2f ms, slowest halo exchange %.2f ms\n",
+                               gen, (long)population[gen], slowestStep[gen] / 1000.0, slowestExchange[gen] / 1000.0);
+                    }
+                }
+                free(message);
+            }
+            else if(type == MSGBLOCK && size >= sizeof(DistBlock))
+            {
+                held[i] = message;
+            }
+            else
+            {
+                // A finished worker hangs up, so stop listening to it
+                if(type == MSGDONE)
+                {
+                    netClose(fds[i]);
+                    fds[i] = -1;
+                    done++;
+                }
+                free(message);
+            }
+        }
+
+        // Copy in every held block that belongs to the current snapshot
+        for(int i = 0; i < count && universe != NULL; i++)
+        {
+            DistBlock *block = held[i];
+
+            if(block == NULL || block->generation != snapshotGen)
+            {
+                continue;
+            }
+
+            Board cells;
+            cells.cells = (Uint64*)(block + 1);
+            cells.w = block->w;
+            cells.h = block->h;
+            cells.stride = (block->w + 63) / 64;
+
+            copyBoardRegion(universe, block->x, block->y, &cells, 0, 0, block->w, block->h);
+            free(held[i]);
+            held[i] = NULL;
+
+            if(++blocksIn == count)
+            {
+                if(config->snapshotFile != NULL)
+                {
+                    writeSnapshot(config->snapshotFile, universe, config->w, config->h);
+                }
+
+                blocksIn = 0;
+                snapshotGen = snapshotGen + config->snapshotEvery < config->generations && config->snapshotEvery > 0
+                            ? snapshotGen + config->snapshotEvery : config->generations;
+
+                // Some held blocks may belong to the new snapshot
+                i = -1;
+            }
+        }
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    if(failed || done < count)
+    {
+        goto done;
+    }
+
+    printf("Stepped %i generations of a %ix%i universe on %ix%i blocks in %.3f s (%.1f gen/s)\n", config->generations,
+           config->w, config->h, config->blocksX, config->blocksY, seconds, config->generations / seconds);
+
+    result = 0;
+
+    if(config->verify)
+    {
+        // Step the same universe in this process, it has to come out identical
+        Board *boards[2];
+        boards[0] = createBoard(config->w, config->h);
+        boards[1] = createBoard(config->w, config->h);
+
+        if(boards[0] == NULL || boards[1] == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            fillBoardSeeded(boards[0], 0, 0, 0, 0, config->w, config->h, config->seed);
+
+            for(int i = 0; i < config->generations; i++)
+            {
+                stepBoard(gEngine, boards[i & 1], boards[(i + 1) & 1], config->w, config->h, config->wrap);
+            }
+
+            Board *expect = boards[config->generations & 1];
+
+            for(int y = 0; y < config->h && result == 0; y++)
+            {
+                for(int x = 0; x < config->w; x++)
+                {
+                    if(BOARDCELL(expect, x, y) != BOARDCELL(universe, x, y))
+                    {
+                        printf("FAIL: cell (%i,%i) differs from the single process %s engine\n", x, y, gEngine->name);
+                        result = 1;
+                        break;
+                    }
+                }
+            }
+
+            if(result == 0)
+            {
+                printf("Result matches the single process %s engine\n", gEngine->name);
+            }
+        }
+
+        freeBoard(boards[0]);
+        freeBoard(boards[1]);
+    }
+
+done:
+    netClose(listenFd);
+
+    for(int i = 0; i < count; i++)
+    {
+        netClose(fds[i]);
+        free(held[i]);
+    }
+
+    // Workers of a failed run may be blocked waiting on the coordinator or a neighbor
+    reapWorkers(result != 0);
+
+    free(population);
+    free(reported);
+    free(slowestStep);
+    free(slowestExchange);
+    freeBoard(universe);
+
+    return result;
+}
+
+int spawnWorkers(DistConfig *config, int count)
+{
+    char address[32];
+    char threads[16];
+
+    snprintf(address, sizeof(address), "127.0.0.1:%i", config->port);
+
+    // Share the cores between the local workers unless told otherwise
+    int perWorker = config->threads > 0 ? config->threads : SDL_GetCPUCount() / count;
+    snprintf(threads, sizeof(threads), "%i", perWorker > 0 ? perWorker : 1);
+
+    for(int i = 0; i < count; i++)
+    {
+        pid_t pid = fork();
+
+        if(pid < 0)
+        {
+            printf("Unable to start worker process! %s\n", strerror(errno));
+            return 0;
+        }
+
+        spawned[spawnedCount++] = pid;
+
+        if(pid == 0)
+        {
+            execl(config->program, config->program, "--worker", address, "--engine", gEngine->name, "--threads", threads, (char*)NULL);
+            printf("Unable to run %s! %s\n", config->program, strerror(errno));
+            _exit(1);
+        }
+    }
+
+    return 1;
+}
+
+int runWorker(char *address)
+{
+    char host[NETHOSTLEN];
+    int port, myPort;
+    int links[4] = { -1, -1, -1, -1 };
+    int result = 1;
+    Uint32 type, size;
+
+    if(!netParseAddress(address, host, NETHOSTLEN, &port))
+    {
+        printf("Bad coordinator address %s!\n", address);
+        return 1;
+    }
+
+    // Neighbors connect here for halo links
+    int listenFd = netListen(0, &myPort);
+    if(listenFd < 0)
+    {
+        return 1;
+    }
+
+    int coordinator = netConnect(host, port);
+    if(coordinator < 0)
+    {
+        netClose(listenFd);
+        return 1;
+    }
+
+    DistHello hello = { DISTABI, myPort };
+    DistAssign *assign = NULL;
+
+    if(netSendMessage(coordinator, MSGHELLO, &hello, sizeof(hello)))
+    {
+        assign = netRecvMessage(coordinator, &type, &size);
+    }
+
+    if(assign == NULL || type != MSGASSIGN || size != sizeof(DistAssign))
+    {
+        printf("No block assigned by the coordinator!\n");
+        free(assign);
+        netClose(coordinator);
+        netClose(listenFd);
+        return 1;
+    }
+
+    // Connect east and south, telling the other side which of its links this is
+    int connectTo[2] = { LINKEAST, LINKSOUTH };
+    int theirSide[2] = { LINKWEST, LINKNORTH };
+    char *linkHost[2] = { assign->eastHost, assign->southHost };
+    int linkPort[2] = { assign->eastPort, assign->southPort };
+    int incoming = assign->hasLink[LINKWEST] + assign->hasLink[LINKNORTH];
+
+    for(int i = 0; i < 2; i++)
+    {
+        if(assign->hasLink[connectTo[i]])
+        {
+            Uint32 side = theirSide[i];
+
+            links[connectTo[i]] = netConnect(linkHost[i], linkPort[i]);
+            if(links[connectTo[i]] < 0 || !netSendAll(links[connectTo[i]], &side, sizeof(side)))
+            {
+                goto done;
+            }
+        }
+    }
+
+    for(int i = 0; i < incoming; i++)
+    {
+        Uint32 side;
+        int fd = netAccept(listenFd, NULL, 0);
+
+        if(fd < 0 || !netRecvAll(fd, &side, sizeof(side)) || side > LINKSOUTH || links[side] >= 0)
+        {
+            printf("Bad halo link!\n");
+            netClose(fd);
+            goto done;
+        }
+
+        links[side] = fd;
+    }
+
+    netClose(listenFd);
+    listenFd = -1;
+
+    int w = assign->w;
+    int h = assign->h;
+
+    // The block plus a one cell halo all around it
+    Board *boards[2];
+    boards[0] = createBoard(w + 2, h + 2);
+    boards[1] = createBoard(w + 2, h + 2);
+    Board *block = createBoard(w, h);
+
+    int columnWords = (h + 63) / 64;
+    int rowWords = (w + 2 + 63) / 64;
+    Uint64 *strips = calloc(4 * (size_t)(columnWords + rowWords), sizeof(Uint64));
+
+    if(boards[0] == NULL || boards[1] == NULL || block == NULL || strips == NULL)
+    {
+        printf("Unable to allocate %ix%i block!\n", w, h);
+        goto cleanup;
+    }
+
+    fillBoardSeeded(boards[0], 1, 1, assign->x, assign->y, w, h, assign->seed);
+
+    for(int gen = 1; gen <= assign->generations; gen++)
+    {
+        Board *cur = boards[(gen - 1) & 1];
+        Uint64 start = SDL_GetPerformanceCounter();
+        Uint64 trace = traceBegin();
+
+        // West and east columns first, then the north and south rows including
+        // the corners just received, so diagonal neighbors need no link of their own
+        for(int phase = 0; phase < 2; phase++)
+        {
+            HaloTransfer transfers[2];
+            int active = 0;
+            int words = phase == 0 ? columnWords : rowWords;
+            int cells = phase == 0 ? h : w + 2;
+
+            // Each side has an outgoing and an incoming strip, columns first then rows
+            Uint64 *phaseStrips = phase == 0 ? strips : strips + 4 * (size_t)columnWords;
+
+            for(int side = phase * 2; side < phase * 2 + 2; side++)
+            {
+                Uint64 *out = phaseStrips + (size_t)(side - phase * 2) * 2 * words;
+                Uint64 *in = out + words;
+
+                // The cells next to this edge go out, the neighbor's cells come into the halo
+                int edge = side == LINKWEST || side == LINKNORTH ? 1 : phase == 0 ? w : h;
+
+                memset(in, 0, words * sizeof(Uint64));
+
+                if(links[side] >= 0)
+                {
+                    if(phase == 0)
+                    {
+                        packStrip(cur, edge, 1, 0, 1, cells, out);
+                    }
+                    else
+                    {
+                        packStrip(cur, 0, edge, 1, 0, cells, out);
+                    }
+
+                    transfers[active].fd = links[side];
+                    transfers[active].send = out;
+                    transfers[active].recv = in;
+                    transfers[active].size = words * sizeof(Uint64);
+                    transfers[active].sent = 0;
+                    transfers[active].received = 0;
+                    active++;
+                }
+            }
+
+            if(!exchangeHalos(transfers, active))
+            {
+                printf("Halo exchange failed in generation %i!\n", gen);
+                goto cleanup;
+            }
+
+            // Unpack after the exchange, the strips sent above must not see these halos
+            for(int side = phase * 2; side < phase * 2 + 2; side++)
+            {
+                Uint64 *in = phaseStrips + (size_t)(side - phase * 2) * 2 * words + words;
+                int halo = side == LINKWEST || side == LINKNORTH ? 0 : phase == 0 ? w + 1 : h + 1;
+
+                if(phase == 0)
+                {
+                    unpackStrip(cur, halo, 1, 0, 1, cells, in);
+                }
+                else
+                {
+                    unpackStrip(cur, 0, halo, 1, 0, cells, in);
+                }
+            }
+        }
+
+        traceEnd("exchangeHalos", trace);
+        Uint64 exchanged = SDL_GetPerformanceCounter();
+
+        trace = traceBegin();
+        stepBoard(gEngine, cur, boards[gen & 1], w + 2, h + 2, 0);
+        traceEnd("stepBlock", trace);
+
+        Uint64 stepped = SDL_GetPerformanceCounter();
+        Board *next = boards[gen & 1];
+        DistStats stats;
+
+        // Leave the halo out of the population
+        stats.generation = gen;
+        stats.rank = assign->rank;
+        stats.population = countBoardCells(next, w + 1, h + 1);
+        for(int x = 0; x < w + 1; x++)
+        {
+            stats.population -= BOARDCELL(next, x, 0);
+        }
+        for(int y = 1; y < h + 1; y++)
+        {
+            stats.population -= BOARDCELL(next, 0, y);
+        }
+        stats.stepMicros = (Uint32)((stepped - exchanged) * 1000000 / SDL_GetPerformanceFrequency());
+        stats.exchangeMicros = (Uint32)((exchanged - start) * 1000000 / SDL_GetPerformanceFrequency());
+
+        if(!netSendMessage(coordinator, MSGSTATS, &stats, sizeof(stats)))
+        {
+            goto cleanup;
+        }
+
+        if((assign->snapshotEvery > 0 && gen % assign->snapshotEvery == 0) || (assign->sendLast && gen == assign->generations))
+        {
+            DistBlock head = { gen, assign->x, assign->y, w, h };
+
+            copyBoardRegion(block, 0, 0, next, 1, 1, w, h);
+
+            if(!netSendMessage2(coordinator, MSGBLOCK, &head, sizeof(head), block->cells, (Uint32)((size_t)h * block->stride * sizeof(Uint64))))
+            {
+                goto cleanup;
+            }
+        }
+    }
+
+    result = !netSendMessage(coordinator, MSGDONE, NULL, 0);
+
+cleanup:
+    freeBoard(boards[0]);
+    freeBoard(boards[1]);
+    freeBoard(block);
+    free(strips);
+
+done:
+    for(int i = 0; i < 4; i++)
+    {
+        netClose(links[i]);
+    }
+
+    free(assign);
+    netClose(coordinator);
+    netClose(listenFd);
+
+    return result;
+}
+
+int exchangeHalos(HaloTransfer *transfers, int count)
+{
+    // Send and receive on every link at once, so two neighbors that both
+    // send a large strip before reading can never block each other
+    for(int i = 0; i < count; i++)
+    {
+        netSetNonBlocking(transfers[i].fd, 1);
+    }
+
+    int pending = count;
+
+    while(pending > 0)
+    {
+        struct pollfd polls[4];
+
+        for(int i = 0; i < count; i++)
+        {
+            polls[i].fd = transfers[i].fd;
+            polls[i].events = (transfers[i].sent < transfers[i].size ? POLLOUT : 0) | (transfers[i].received < transfers[i].size ? POLLIN : 0);
+            polls[i].revents = 0;
+        }
+
+        if(poll(polls, count, -1) < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return 0;
+        }
+
+        pending = 0;
+
+        for(int i = 0; i < count; i++)
+        {
+            HaloTransfer *t = &transfers[i];
+
+            if(polls[i].revents & (POLLERR | POLLNVAL))
+            {
+                return 0;
+            }
+
+            if((polls[i].revents & POLLOUT) && t->sent < t->size)
+            {
+                ssize_t n = send(t->fd, (char*)t->send + t->sent, t->size - t->sent, 0);
+                if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    return 0;
+                }
+                t->sent += n > 0 ? n : 0;
+            }
+
+            if((polls[i].revents & (POLLIN | POLLHUP)) && t->received < t->size)
+            {
+                ssize_t n = recv(t->fd, (char*)t->recv + t->received, t->size - t->received, 0);
+                if(n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                {
+                    return 0;
+                }
+                t->received += n > 0 ? n : 0;
+            }
+
+            if(t->sent < t->size || t->received < t->size)
+            {
+                pending++;
+            }
+        }
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        netSetNonBlocking(transfers[i].fd, 0);
+    }
+
+    return 1;
+}
+
+#else
+
+int runCoordinator(DistConfig *config)
+{
+    printf("Distributed mode is not supported on this platform!\n");
+    return 1;
+}
+
+int runWorker(char *address)
+{
+    printf("Distributed mode is not supported on this platform!\n");
+    return 1;
+}
+
+#endif
+
+void packStrip(Board *board, int x, int y, int dx, int dy, int count, Uint64 *bits)
+{
+    memset(bits, 0, ((count + 63) / 64) * sizeof(Uint64));
+
+    for(int i = 0; i < count; i++)
+    {
+        bits[i >> 6] |= (Uint64)BOARDCELL(board, x + i * dx, y + i * dy) << (i & 63);
+    }
+}
+
+void unpackStrip(Board *board, int x, int y, int dx, int dy, int count, Uint64 *bits)
+{
+    for(int i = 0; i < count; i++)
+    {
+        setBoardCell(board, x + i * dx, y + i * dy, (int)((bits[i >> 6] >> (i & 63)) & 1));
+    }
+}
+
+int writeSnapshot(char *filename, Board *board, int w, int h)
+{
+    FILE *file = fopen(filename, "wb");
+    if(file == NULL)
+    {
+        printf("Unable to write snapshot %s!\n", filename);
+        return 0;
+    }
+
+    // Binary PBM, live cells are black
+    fprintf(file, "P4\n%i %i\n", w, h);
+
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x += 8)
+        {
+            int byte = 0;
+
+            for(int i = 0; i < 8; i++)
+            {
+                byte = (byte << 1) | (x + i < w ? BOARDCELL(board, x + i, y) : 0);
+            }
+
+            fputc(byte, file);
+        }
+    }
+
+    fclose(file);
+    return 1;
+}
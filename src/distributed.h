@@ -0,0 +1,127 @@
+// ###########################################################################
+//          Title: YaGoL Distributed Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Splits a universe into blocks stepped by separate worker
+//                 processes, which swap one cell halo strips with their
+//                 neighbors every generation. A coordinator hands out the
+//                 blocks and gathers statistics and snapshots.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "engine.h"
+#include "net.h"
+
+#define MAXBLOCKS 1024
+
+// Messages are sent as the raw structs below, in host byte order and layout,
+// so every node has to share the same ABI. Workers send this in their hello
+// and the coordinator turns away any that lay the structs out differently
+#define DISTABI (0x59470000u | (Uint32)sizeof(DistAssign))
+
+enum DISTMESSAGE
+{
+    MSGHELLO = 1, // Worker -> coordinator: port the worker accepts halo links on
+    MSGASSIGN = 2, // Coordinator -> worker: the block it owns and who its neighbors are
+    MSGSTATS = 3, // Worker -> coordinator: population and timings of one generation
+    MSGBLOCK = 4, // Worker -> coordinator: cells of the block for a snapshot
+    MSGDONE = 5 // Worker -> coordinator: all generations stepped
+};
+
+enum DISTLINK
+{
+    LINKWEST = 0,
+    LINKEAST = 1,
+    LINKNORTH = 2,
+    LINKSOUTH = 3
+};
+
+typedef struct DISTCONFIG_S
+{
+    int port; // Port the coordinator listens on
+    int blocksX;
+    int blocksY;
+    int w; // Universe size in cells
+    int h;
+    int generations;
+    int wrap;
+    Uint64 seed; // Initial universe, see fillBoardSeeded
+    int spawn; // Start the workers as processes on this machine
+    int verify; // Also step the whole universe in this process and compare
+    char *snapshotFile; // PBM image of the universe, rewritten at every snapshot
+    int snapshotEvery; // Generations between snapshots, 0 for only the last one
+    char *program; // Path of this executable, for spawning workers
+    int threads; // Threads per spawned worker
+} DistConfig;
+
+typedef struct DISTHELLO_S
+{
+    Uint32 abi; // DISTABI as the worker sees it
+    Sint32 port;
+} DistHello;
+
+typedef struct DISTASSIGN_S
+{
+    Sint32 rank;
+    Sint32 x; // Region of the universe owned by the worker
+    Sint32 y;
+    Sint32 w;
+    Sint32 h;
+    Sint32 generations;
+    Sint32 snapshotEvery;
+    Sint32 sendLast; // Send the block after the last generation
+    Uint64 seed;
+    Sint32 hasLink[4]; // Indexed by DISTLINK, 0 where the edge of the universe is dead
+    char eastHost[NETHOSTLEN]; // Workers connect east and south, and accept west and north
+    Sint32 eastPort;
+    char southHost[NETHOSTLEN];
+    Sint32 southPort;
+} DistAssign;
+
+typedef struct DISTSTATS_S
+{
+    Sint32 generation;
+    Sint32 rank;
+    Sint64 population;
+    Uint32 stepMicros;
+    Uint32 exchangeMicros;
+} DistStats;
+
+typedef struct DISTBLOCK_S
+{
+    Sint32 generation;
+    Sint32 x;
+    Sint32 y;
+    Sint32 w;
+    Sint32 h; // Followed by h rows of (w + 63) / 64 words
+} DistBlock;
+
+typedef struct HALOTRANSFER_S
+{
+    int fd;
+    Uint64 *send;
+    Uint64 *recv;
+    size_t size; // Bytes each way
+    size_t sent;
+    size_t received;
+} HaloTransfer;
+
+int runCoordinator(DistConfig *config);
+int runWorker(char *address);
+int spawnWorkers(DistConfig *config, int count);
+int exchangeHalos(HaloTransfer *transfers, int count);
+void packStrip(Board *board, int x, int y, int dx, int dy, int count, Uint64 *bits);
+void unpackStrip(Board *board, int x, int y, int dx, int dy, int count, Uint64 *bits);
+int writeSnapshot(char *filename, Board *board, int w, int h);
+
+#endif
@@ -0,0 +1,683 @@
+// ###########################################################################
+//          Title: YaGoL Engine Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Packed bit boards and the kernels that step them. The
+//                 kernel is built for several instruction sets and the
+//                 best one the CPU supports is picked at startup.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "engine.h"
+#include "workers.h"
+#include "trace.h"
+
+// Ordered from slowest to fastest, "auto" picks the last available one
+Engine Engines[] =
+{
+    { "reference", NULL, 1 },
+    { "generic", stepRowsGeneric, 1 },
+#ifdef KERNELS_X86
+    { "avx2", stepRowsAvx2, 0 },
+    { "avx512", stepRowsAvx512, 0 },
+#endif
+};
+
+int engineCount = sizeof(Engines) / sizeof(Engines[0]);
+
+Engine *gEngine = NULL; // Engine stepping the grid
+
+Board* createBoard(int w, int h)
+{
+    Board *board = malloc(sizeof(Board));
+    if(board == NULL)
+    {
+        printf("Unable to allocate board!\n");
+        return NULL;
+    }
+
+    board->w = w;
+    board->h = h;
+    board->stride = (w + 63) / 64;
+
+    // One extra row of dead cells is read in place of the rows past the edges
+    board->cells = calloc((size_t)(h + 1) * board->stride, sizeof(Uint64));
+    if(board->cells == NULL)
+    {
+        printf("Unable to allocate %ix%i board!\n", w, h);
+        free(board);
+        return NULL;
+    }
+
+    return board;
+}
+
+void freeBoard(Board *board)
+{
+    if(board != NULL)
+    {
+        free(board->cells);
+        free(board);
+    }
+}
+
+void clearBoard(Board *board)
+{
+    memset(board->cells, 0, (size_t)board->h * board->stride * sizeof(Uint64));
+}
+
+void copyBoard(Board *dst, Board *src)
+{
+    memcpy(dst->cells, src->cells, (size_t)src->h * src->stride * sizeof(Uint64));
+}
+
+void randomizeBoard(Board *board, Uint64 seed)
+{
+    Uint64 state = seed ^ 0x9E3779B97F4A7C15ull;
+    Uint64 lastMask = board->w % 64 ? ((Uint64)1 << (board->w % 64)) - 1 : ~(Uint64)0;
+
+    // Every xorshift64 step fills 64 cells
+    for(int y = 0; y < board->h; y++)
+    {
+        Uint64 *row = board->cells + (size_t)y * board->stride;
+
+        for(int i = 0; i < board->stride; i++)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            row[i] = state;
+        }
+
+        row[board->stride - 1] &= lastMask;
+    }
+}
+
+Uint64 seededWord(Uint64 seed, int wordX, int y)
+{
+    // Cells 64 * wordX to 64 * wordX + 63 of row y of a seeded universe
+    Uint64 z = seed + (Uint64)y * 0x9E3779B97F4A7C15ull + (Uint64)wordX * 0xD1B54A32D192ED03ull;
+
+    // splitmix64 finalizer
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void fillBoardSeeded(Board *board, int bx, int by, int x0, int y0, int w, int h, Uint64 seed)
+{
+    // Each cell only depends on the seed and its position in the universe,
+    // so any piece of a universe can be filled without filling the rest
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            Uint64 z = seededWord(seed, (x0 + x) >> 6, y0 + y);
+            setBoardCell(board, bx + x, by + y, (int)((z >> ((x0 + x) & 63)) & 1));
+        }
+    }
+}
+
+void copyBoardRegion(Board *dst, int dx, int dy, Board *src, int sx, int sy, int w, int h)
+{
+    blitBoard(dst, dx, dy, dst->w, dst->h, src, sx, sy, w, h, BLITCOPY);
+}
+
+Uint64 randomBits(Uint64 *state, int density)
+{
+    Uint64 bits = 0;
+
+    // Each bit of the density, lowest first, ORs or ANDs in a fresh random
+    // word, leaving every cell alive with probability density / 256
+    for(int i = 0; i < 8; i++)
+    {
+        *state ^= *state << 13;
+        *state ^= *state >> 7;
+        *state ^= *state << 17;
+        bits = (density >> i) & 1 ? bits | *state : bits & *state;
+    }
+
+    return bits;
+}
+
+void fillBoardRegion(Board *board, int x0, int y0, int w, int h, int density, Uint64 seed)
+{
+    // Density is the percentage of cells left alive, so 0 clears the region and 100 fills it
+    Uint64 state = seed ^ 0x9E3779B97F4A7C15ull;
+    int level = density * 256 / 100;
+
+    if(x0 < 0)
+    {
+        w += x0;
+        x0 = 0;
+    }
+
+    if(y0 < 0)
+    {
+        h += y0;
+        y0 = 0;
+    }
+
+    w = x0 + w > board->w ? board->w - x0 : w;
+    h = y0 + h > board->h ? board->h - y0 : h;
+
+    if(w <= 0 || h <= 0)
+    {
+        return;
+    }
+
+    int first = x0 >> 6;
+    int last = (x0 + w - 1) >> 6;
+
+    // Whole words are cleared, filled or randomized under a mask of the region's columns
+    for(int y = y0; y < y0 + h; y++)
+    {
+        Uint64 *row = board->cells + (size_t)y * board->stride;
+
+        for(int i = first; i <= last; i++)
+        {
+            long start = (long)i * 64;
+            Uint64 mask = ~(Uint64)0;
+
+            if(start < x0)
+            {
+                mask &= ~(Uint64)0 << (x0 - start);
+            }
+
+            if(start + 64 > x0 + w)
+            {
+                mask &= ~(Uint64)0 >> (start + 64 - (x0 + w));
+            }
+
+            Uint64 bits = level <= 0 ? 0 : level >= 256 ? ~(Uint64)0 : randomBits(&state, level);
+            row[i] = (row[i] & ~mask) | (bits & mask);
+        }
+    }
+}
+
+Uint64 rowBits(const Uint64 *row, int stride, long x)
+{
+    // 64 cells of a row starting at cell x, reading cells off either end as dead
+    if(x <= -64)
+    {
+        return 0;
+    }
+
+    if(x < 0)
+    {
+        return rowBits(row, stride, 0) << -x;
+    }
+
+    long word = x >> 6;
+    int shift = x & 63;
+    Uint64 lo = word < stride ? row[word] : 0;
+    Uint64 hi = word + 1 < stride ? row[word + 1] : 0;
+
+    return shift ? (lo >> shift) | (hi << (64 - shift)) : lo;
+}
+
+void blitBoard(Board *dst, int dx, int dy, int clipW, int clipH, Board *src, int sx, int sy, int w, int h, int op)
+{
+    // Clip to the top left clipW x clipH cells of dst
+    if(dx < 0)
+    {
+        sx -= dx;
+        w += dx;
+        dx = 0;
+    }
+
+    if(dy < 0)
+    {
+        sy -= dy;
+        h += dy;
+        dy = 0;
+    }
+
+    if(clipW > dst->w)
+    {
+        clipW = dst->w;
+    }
+
+    if(clipH > dst->h)
+    {
+        clipH = dst->h;
+    }
+
+    w = dx + w > clipW ? clipW - dx : w;
+    h = dy + h > clipH ? clipH - dy : h;
+
+    if(w <= 0 || h <= 0)
+    {
+        return;
+    }
+
+    int first = dx >> 6;
+    int last = (dx + w - 1) >> 6;
+
+    for(int y = 0; y < h; y++)
+    {
+        const Uint64 *from = src->cells + (size_t)(sy + y) * src->stride;
+        Uint64 *to = dst->cells + (size_t)(dy + y) * dst->stride;
+
+        // Every destination word takes 64 source cells lined up with it by one shifted read
+        for(int i = first; i <= last; i++)
+        {
+            long start = (long)i * 64;
+            Uint64 mask = ~(Uint64)0;
+
+            if(start < dx)
+            {
+                mask &= ~(Uint64)0 << (dx - start);
+            }
+
+            if(start + 64 > dx + w)
+            {
+                mask &= ~(Uint64)0 >> (start + 64 - (dx + w));
+            }
+
+            Uint64 bits = rowBits(from, src->stride, sx + (start - dx)) & mask;
+
+            switch(op)
+            {
+                case BLITCOPY: to[i] = (to[i] & ~mask) | bits;
+                    break;
+                case BLITOR: to[i] |= bits;
+                    break;
+                case BLITXOR: to[i] ^= bits;
+                    break;
+                case BLITCLEAR: to[i] &= ~bits;
+                    break;
+            }
+        }
+    }
+}
+
+void transpose64(Uint64 *a)
+{
+    // Swap ever smaller off-diagonal blocks of the 64x64 bit matrix
+    Uint64 m = 0x00000000FFFFFFFFull;
+
+    for(int j = 32; j != 0; j >>= 1, m ^= m << j)
+    {
+        for(int k = 0; k < 64; k = ((k | j) + 1) & ~j)
+        {
+            Uint64 t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+    }
+}
+
+Uint64 reverse64(Uint64 x)
+{
+    x = ((x >> 1) & 0x5555555555555555ull) | ((x & 0x5555555555555555ull) << 1);
+    x = ((x >> 2) & 0x3333333333333333ull) | ((x & 0x3333333333333333ull) << 2);
+    x = ((x >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((x & 0x0F0F0F0F0F0F0F0Full) << 4);
+    x = ((x >> 8) & 0x00FF00FF00FF00FFull) | ((x & 0x00FF00FF00FF00FFull) << 8);
+    x = ((x >> 16) & 0x0000FFFF0000FFFFull) | ((x & 0x0000FFFF0000FFFFull) << 16);
+
+    return (x >> 32) | (x << 32);
+}
+
+Board* transformBoard(Board *src, int w, int h, int orientation)
+{
+    int transpose = orientation & ORIENTTRANSPOSE;
+    int outW = transpose ? h : w;
+    int outH = transpose ? w : h;
+
+    Board *dst = createBoard(outW, outH);
+    if(dst == NULL)
+    {
+        return NULL;
+    }
+
+    // Transposing works on 64x64 blocks, each a single row of words in and out
+    if(transpose)
+    {
+        Uint64 block[64];
+
+        for(int by = 0; by < h; by += 64)
+        {
+            for(int bx = 0; bx < w; bx += 64)
+            {
+                for(int i = 0; i < 64; i++)
+                {
+                    block[i] = by + i < h ? src->cells[(size_t)(by + i) * src->stride + (bx >> 6)] : 0;
+                }
+
+                transpose64(block);
+
+                for(int i = 0; i < 64 && bx + i < w; i++)
+                {
+                    dst->cells[(size_t)(bx + i) * dst->stride + (by >> 6)] = block[i];
+                }
+            }
+        }
+    }
+    else
+    {
+        copyBoardRegion(dst, 0, 0, src, 0, 0, w, h);
+    }
+
+    // Cells past the right edge of the source came along with the last words, so clear them
+    Uint64 lastMask = outW % 64 ? ((Uint64)1 << (outW % 64)) - 1 : ~(Uint64)0;
+    Uint64 *row = malloc(dst->stride * sizeof(Uint64));
+    if(row == NULL)
+    {
+        freeBoard(dst);
+        return NULL;
+    }
+
+    for(int y = 0; y < outH; y++)
+    {
+        Uint64 *cells = dst->cells + (size_t)y * dst->stride;
+
+        cells[dst->stride - 1] &= lastMask;
+
+        // Reversing the words and their bits mirrors the row, which then
+        // has to be shifted back down by the unused bits of the last word
+        if(orientation & ORIENTFLIPX)
+        {
+            for(int i = 0; i < dst->stride; i++)
+            {
+                row[i] = reverse64(cells[dst->stride - 1 - i]);
+            }
+
+            for(int i = 0; i < dst->stride; i++)
+            {
+                cells[i] = rowBits(row, dst->stride, (long)i * 64 + (long)dst->stride * 64 - outW);
+            }
+
+            cells[dst->stride - 1] &= lastMask;
+        }
+    }
+
+    free(row);
+
+    if(orientation & ORIENTFLIPY)
+    {
+        for(int y = 0; y < outH / 2; y++)
+        {
+            Uint64 *a = dst->cells + (size_t)y * dst->stride;
+            Uint64 *b = dst->cells + (size_t)(outH - 1 - y) * dst->stride;
+
+            for(int i = 0; i < dst->stride; i++)
+            {
+                Uint64 t = a[i];
+                a[i] = b[i];
+                b[i] = t;
+            }
+        }
+    }
+
+    return dst;
+}
+
+int setBoardCell(Board *board, int x, int y, int alive)
+{
+    Uint64 bit = (Uint64)1 << (x & 63);
+    Uint64 *word = &BOARDWORD(board, x, y);
+    int was = (*word & bit) != 0;
+
+    if(alive)
+    {
+        *word |= bit;
+    }
+    else
+    {
+        *word &= ~bit;
+    }
+
+    // Return 1 if the cell changed
+    return was != (alive != 0);
+}
+
+long countBoardCells(Board *board, int w, int h)
+{
+    long count = 0;
+    int words = (w + 63) / 64;
+    Uint64 lastMask = w % 64 ? ((Uint64)1 << (w % 64)) - 1 : ~(Uint64)0;
+
+    for(int y = 0; y < h; y++)
+    {
+        Uint64 *row = board->cells + (size_t)y * board->stride;
+
+        for(int i = 0; i < words; i++)
+        {
+            count += __builtin_popcountll(i == words - 1 ? row[i] & lastMask : row[i]);
+        }
+    }
+
+    return count;
+}
+
+int countBoardNeighbors(Board *board, int x, int y, int w, int h, int wrap)
+{
+    // The number of live neighbors
+    int value = 0;
+
+    // This nested loop enumerates the 9 cells in the specified cells neighborhood
+    for(int j = -1; j <= 1; j++)
+    {
+        // If wrap is set to 0 and y+j is off the board, continue
+        if(!wrap && (y + j < 0 || y + j >= h))
+        {
+            continue;
+        }
+
+        // Loop around the edges if y+j is off the board
+        int k = (y + j + h) % h;
+
+        for(int i = -1; i <= 1; i++)
+        {
+            // If wrap is set to 0 and x+i is off the board, continue
+            if(!wrap && (x + i < 0 || x + i >= w))
+            {
+                continue;
+            }
+
+            // Loop around the edges if x+i is off the board
+            int l = (x + i + w) % w;
+
+            // Count the neighbor cell at (l,k) if it is alive
+            value += BOARDCELL(board, l, k);
+        }
+    }
+
+    // Subtract 1 if (x,y) is alive since we counted it as a neighbor
+    return value - BOARDCELL(board, x, y);
+}
+
+Engine* findEngine(char *name)
+{
+    for(int i = 0; i < engineCount; i++)
+    {
+        if(strcmp(Engines[i].name, name) == 0)
+        {
+            return &Engines[i];
+        }
+    }
+
+    return NULL;
+}
+
+Engine* selectEngine(char *name)
+{
+#ifdef KERNELS_X86
+    // SDL checks CPUID (and that the OS saves the wide registers)
+    findEngine("avx2")->available = SDL_HasAVX2();
+    findEngine("avx512")->available = SDL_HasAVX512F();
+#endif
+
+    if(name == NULL || strcmp(name, "auto") == 0)
+    {
+        for(int i = engineCount - 1; i >= 0; i--)
+        {
+            if(Engines[i].available)
+            {
+                return &Engines[i];
+            }
+        }
+    }
+
+    Engine *engine = findEngine(name);
+    if(engine == NULL)
+    {
+        printf("Unknown engine %s!\n", name);
+        return NULL;
+    }
+
+    if(!engine->available)
+    {
+        printf("The %s engine is not supported by this CPU!\n", name);
+        return NULL;
+    }
+
+    return engine;
+}
+
+void stepBand(void *data, int item)
+{
+    StepJob *job = data;
+    Uint64 start = traceBegin();
+    int y0 = item * BANDROWS;
+    int y1 = y0 + BANDROWS < job->h ? y0 + BANDROWS : job->h;
+
+    job->engine->stepRows(job->src->cells, job->dst->cells, job->src->cells + (size_t)job->src->h * job->src->stride,
+                          job->src->stride, job->w, job->h, job->wrap, y0, y1);
+
+    // Let the caller use the new rows while they are still in cache
+    if(job->bandDone != NULL)
+    {
+        job->bandDone(job, y0, y1);
+    }
+
+    traceEnd("stepBand", start);
+}
+
+void stepBoard(Engine *engine, Board *src, Board *dst, int w, int h, int wrap)
+{
+    if(engine->stepRows == NULL)
+    {
+        stepReference(src, dst, w, h, wrap);
+        return;
+    }
+
+    StepJob job = { engine, src, dst, w, h, wrap, NULL, NULL };
+    runWorkers(stepBand, &job, (h + BANDROWS - 1) / BANDROWS);
+}
+
+void stepBatchBand(void *data, int item)
+{
+    StepBatch *batch = data;
+    int job = 0;
+
+    // Find the board this band belongs to, there are only ever a few of them
+    while(item >= (batch->jobs[job].h + BANDROWS - 1) / BANDROWS)
+    {
+        item -= (batch->jobs[job].h + BANDROWS - 1) / BANDROWS;
+        job++;
+    }
+
+    stepBand(&batch->jobs[job], item);
+}
+
+void stepBoards(Engine *engine, StepJob *jobs, int count)
+{
+    if(engine->stepRows == NULL)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            stepReference(jobs[i].src, jobs[i].dst, jobs[i].w, jobs[i].h, jobs[i].wrap);
+
+            if(jobs[i].bandDone != NULL)
+            {
+                jobs[i].bandDone(&jobs[i], 0, jobs[i].h);
+            }
+        }
+
+        return;
+    }
+
+    // Bands of every board go out as one job, so small boards still keep every thread busy
+    StepBatch batch = { jobs, count };
+    int items = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        jobs[i].engine = engine;
+        items += (jobs[i].h + BANDROWS - 1) / BANDROWS;
+    }
+
+    runWorkers(stepBatchBand, &batch, items);
+}
+
+void stepBoardSerial(Engine *engine, Board *src, Board *dst, int w, int h, int wrap)
+{
+    // For callers that are already one of many jobs on the worker pool
+    if(engine->stepRows == NULL)
+    {
+        stepReference(src, dst, w, h, wrap);
+        return;
+    }
+
+    engine->stepRows(src->cells, dst->cells, src->cells + (size_t)src->h * src->stride, src->stride, w, h, wrap, 0, h);
+}
+
+void stepReference(Board *src, Board *dst, int w, int h, int wrap)
+{
+    for(int y = 0; y < h; y++)
+    {
+        for(int x = 0; x < w; x++)
+        {
+            int n = countBoardNeighbors(src, x, y, w, h, wrap);
+            int c = BOARDCELL(src, x, y);
+
+            // A live cell dies unless it has exactly 2 or 3 live neighbors
+            // A dead cell remains dead unless it has exactly 3 live neighbors
+            setBoardCell(dst, x, y, (c && (n == 2 || n == 3)) || (!c && n == 3));
+        }
+    }
+}
+
+int runBenchmark(Engine *engine, int size, int generations)
+{
+    Board *boards[2];
+
+    boards[0] = createBoard(size, size);
+    boards[1] = createBoard(size, size);
+    if(boards[0] == NULL || boards[1] == NULL)
+    {
+        freeBoard(boards[0]);
+        freeBoard(boards[1]);
+        return 1;
+    }
+
+    randomizeBoard(boards[0], 1);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for(int i = 0; i < generations; i++)
+    {
+        stepBoard(engine, boards[i & 1], boards[(i + 1) & 1], size, size, 0);
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    printf("Engine %s, %i threads, %ix%i board\n", engine->name, workerCount(), size, size);
+    printf("%i generations in %.3f s: %.1f gen/s, %.1f Mcells/s, %li cells alive\n", generations, seconds,
+           generations / seconds, (double)size * size * generations / seconds / 1e6,
+           countBoardCells(boards[generations & 1], size, size));
+
+    freeBoard(boards[0]);
+    freeBoard(boards[1]);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+// ###########################################################################
+//          Title: YaGoL Engine Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Packed bit boards and the kernels that step them. The
+//                 kernel is built for several instruction sets and the
+//                 best one the CPU supports is picked at startup.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <SDL2/SDL.h>
+
+#define BANDROWS 16 // Rows stepped by each worker job, a multiple of the mip texel height (checked in grid.c)
+#define BENCHSIZE 2048 // Default board size of the benchmark
+
+// Word holding cell (x,y), the cell is bit x % 64 of it
+#define BOARDWORD(board, x, y) ((board)->cells[(size_t)(y) * (board)->stride + ((x) >> 6)])
+#define BOARDCELL(board, x, y) ((int)((BOARDWORD(board, x, y) >> ((x) & 63)) & 1))
+
+// Orientations are combinations of these, applied in this order
+#define ORIENTTRANSPOSE 4
+#define ORIENTFLIPX 1
+#define ORIENTFLIPY 2
+
+enum BLITOP
+{
+    BLITCOPY = 0, // Source cells replace the destination
+    BLITOR = 1, // Live source cells are added
+    BLITXOR = 2, // Live source cells are toggled
+    BLITCLEAR = 3 // Live source cells are killed
+};
+
+// Steps rows [y0, y1) of the w x h region at the top left of src into dst,
+// reading outside the region as dead cells (or wrapping around if wrap is set)
+typedef void (*StepRowsFn)(const Uint64 *src, Uint64 *dst, const Uint64 *zero, int stride, int w, int h, int wrap, int y0, int y1);
+
+typedef struct BOARD_S
+{
+    Uint64 *cells; // Rows of stride words, followed by one row of dead cells
+    int w; // Width in cells
+    int h; // Height in cells
+    int stride; // Words per row
+} Board;
+
+typedef struct ENGINE_S
+{
+    char *name;
+    StepRowsFn stepRows; // NULL for the cell by cell reference stepper
+    int available; // Built in and supported by this CPU
+} Engine;
+
+typedef struct STEPJOB_S
+{
+    Engine *engine;
+    Board *src;
+    Board *dst;
+    int w;
+    int h;
+    int wrap;
+    void (*bandDone)(struct STEPJOB_S *job, int y0, int y1); // Called on the worker once rows [y0, y1) are stepped, or NULL
+    void *bandData; // Passed along to bandDone
+} StepJob;
+
+typedef struct STEPBATCH_S
+{
+    StepJob *jobs;
+    int count;
+} StepBatch;
+
+extern Engine Engines[];
+extern int engineCount;
+
+Board* createBoard(int w, int h);
+void freeBoard(Board *board);
+void clearBoard(Board *board);
+void copyBoard(Board *dst, Board *src);
+void randomizeBoard(Board *board, Uint64 seed);
+Uint64 seededWord(Uint64 seed, int wordX, int y);
+void fillBoardSeeded(Board *board, int bx, int by, int x0, int y0, int w, int h, Uint64 seed);
+void copyBoardRegion(Board *dst, int dx, int dy, Board *src, int sx, int sy, int w, int h);
+Uint64 randomBits(Uint64 *state, int density);
+void fillBoardRegion(Board *board, int x0, int y0, int w, int h, int density, Uint64 seed);
+Uint64 rowBits(const Uint64 *row, int stride, long x);
+void blitBoard(Board *dst, int dx, int dy, int clipW, int clipH, Board *src, int sx, int sy, int w, int h, int op);
+void transpose64(Uint64 *a);
+Uint64 reverse64(Uint64 x);
+Board* transformBoard(Board *src, int w, int h, int orientation);
+int setBoardCell(Board *board, int x, int y, int alive);
+long countBoardCells(Board *board, int w, int h);
+int countBoardNeighbors(Board *board, int x, int y, int w, int h, int wrap);
+Engine* findEngine(char *name);
+Engine* selectEngine(char *name);
+void stepBoard(Engine *engine, Board *src, Board *dst, int w, int h, int wrap);
+void stepBand(void *data, int item);
+void stepBatchBand(void *data, int item);
+void stepBoards(Engine *engine, StepJob *jobs, int count);
+void stepBoardSerial(Engine *engine, Board *src, Board *dst, int w, int h, int wrap);
+void stepReference(Board *src, Board *dst, int w, int h, int wrap);
+int runBenchmark(Engine *engine, int size, int generations);
+
+void stepRowsGeneric(const Uint64 *src, Uint64 *dst, const Uint64 *zero, int stride, int w, int h, int wrap, int y0, int y1);
+#ifdef KERNELS_X86
+void stepRowsAvx2(const Uint64 *src, Uint64 *dst, const Uint64 *zero, int stride, int w, int h, int wrap, int y0, int y1);
+void stepRowsAvx512(const Uint64 *src, Uint64 *dst, const Uint64 *zero, int stride, int w, int h, int wrap, int y0, int y1);
+#endif
+
+#endif
@@ -0,0 +1,172 @@
+// ###########################################################################
+//          Title: YaGoL Export Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Publishes every generation into a ring of slots in POSIX
+//                 shared memory, for analysis tools to map and read in place.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "export.h"
+#include "trace.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+int openExport(Export *export, char *name, int w, int h, int slots)
+{
+    memset(export, 0, sizeof(Export));
+
+    if(w < 1 || h < 1 || slots < 2)
+    {
+        printf("Unable to export a %ix%i universe in %i slots!\n", w, h, slots);
+        return 0;
+    }
+
+    // Shared memory names start with a slash
+    snprintf(export->name, sizeof(export->name), "%s%s", name[0] == '/' ? "" : "/", name);
+
+    size_t slotBytes = EXPORTSLOTHEADER + (size_t)h * ((w + 63) >> 6) * sizeof(Uint64);
+    slotBytes = (slotBytes + EXPORTSLOTHEADER - 1) & ~(size_t)(EXPORTSLOTHEADER - 1);
+    export->size = EXPORTHEADERSIZE + slotBytes * slots;
+
+    // Start over from a new object, readers still mapping one left by an
+    // earlier run keep it until they see it closed
+    shm_unlink(export->name);
+
+    int fd = shm_open(export->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if(fd < 0)
+    {
+        printf("Unable to create shared memory %s! %s\n", export->name, strerror(errno));
+        return 0;
+    }
+
+    if(ftruncate(fd, (off_t)export->size) < 0)
+    {
+        printf("Unable to size shared memory %s! %s\n", export->name, strerror(errno));
+        close(fd);
+        shm_unlink(export->name);
+        return 0;
+    }
+
+    export->map = mmap(NULL, export->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(export->map == MAP_FAILED)
+    {
+        printf("Unable to map shared memory %s! %s\n", export->name, strerror(errno));
+        export->map = NULL;
+        shm_unlink(export->name);
+        return 0;
+    }
+
+    // The new object is all zeros, so every slot starts out as never written
+    export->header = (ExportHeader*)export->map;
+    export->header->slots = slots;
+    export->header->maxW = w;
+    export->header->maxH = h;
+    export->header->slotBytes = slotBytes;
+    export->header->frequency = SDL_GetPerformanceFrequency();
+    export->header->published = 0;
+    export->header->state = EXPORTOPEN;
+
+    // Readers check the magic last, once the rest of the header is there
+    SDL_MemoryBarrierRelease();
+    memcpy(export->header->magic, EXPORTMAGIC, sizeof(export->header->magic));
+
+    printf("Exporting generations to shared memory %s (%i slots of %zu bytes)\n", export->name, slots, slotBytes);
+
+    return 1;
+}
+
+void publishBoard(Export *export, Board *board, int w, int h, int wrap, int universe, Uint64 generation)
+{
+    if(export->header == NULL)
+    {
+        return;
+    }
+
+    Uint64 start = traceBegin();
+    ExportHeader *header = export->header;
+    Uint64 entry = ++export->entries;
+    ExportSlot *slot = (ExportSlot*)(export->map + EXPORTHEADERSIZE + header->slotBytes * ((entry - 1) % (Uint64)header->slots));
+    Uint64 *cells = (Uint64*)((Uint8*)slot + EXPORTSLOTHEADER);
+
+    // Parts of a board bigger than the slots are left out
+    w = w < header->maxW ? w : header->maxW;
+    h = h < header->maxH ? h : header->maxH;
+
+    int stride = (w + 63) >> 6;
+    Uint64 lastMask = w & 63 ? ((Uint64)1 << (w & 63)) - 1 : ~(Uint64)0;
+
+    // Readers that see an odd sequence, or one that changed while they read, skip the slot
+    slot->sequence = 2 * entry - 1;
+    SDL_MemoryBarrierRelease();
+
+    slot->generation = generation;
+    slot->ticks = SDL_GetPerformanceCounter();
+    slot->universe = universe;
+    slot->w = w;
+    slot->h = h;
+    slot->stride = stride;
+    slot->wrap = wrap;
+
+    // Rows are packed to the exported width, with no live cells past w
+    for(int y = 0; y < h; y++)
+    {
+        memcpy(&cells[(size_t)y * stride], &board->cells[(size_t)y * board->stride], stride * sizeof(Uint64));
+        cells[(size_t)y * stride + stride - 1] &= lastMask;
+    }
+
+    SDL_MemoryBarrierRelease();
+    slot->sequence = 2 * entry;
+    header->published = entry;
+
+    traceEnd("publishBoard", start);
+}
+
+void closeExport(Export *export)
+{
+    if(export->header == NULL)
+    {
+        return;
+    }
+
+    // Readers that have it mapped can still read the last generations
+    export->header->state = EXPORTCLOSED;
+    munmap(export->map, export->size);
+    shm_unlink(export->name);
+    export->map = NULL;
+    export->header = NULL;
+}
+
+#else
+
+// Shared memory export is only built on POSIX systems for now
+int openExport(Export *export, char *name, int w, int h, int slots)
+{
+    memset(export, 0, sizeof(Export));
+    printf("Shared memory export is not supported on this platform!\n");
+    return 0;
+}
+
+void publishBoard(Export *export, Board *board, int w, int h, int wrap, int universe, Uint64 generation)
+{
+}
+
+void closeExport(Export *export)
+{
+}
+
+#endif
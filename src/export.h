@@ -0,0 +1,77 @@
+// ###########################################################################
+//          Title: YaGoL Export Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Publishes every generation into a ring of slots in POSIX
+//                 shared memory, for analysis tools to map and read in place.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "engine.h"
+
+#define EXPORTMAGIC "YAGOLSM1"
+#define EXPORTSLOTS 8 // Default number of generations kept in the ring
+#define EXPORTHEADERSIZE 4096 // Slots start on a page boundary
+#define EXPORTSLOTHEADER 64 // Cells start on a cache line within each slot
+
+enum EXPORTSTATE
+{
+    EXPORTOPEN = 1, // Generations are being published
+    EXPORTCLOSED = 2 // The writer has gone, the last generations are left as they were
+};
+
+// The layout is shared with other programs, so it only uses fixed size
+// fields. The writer never waits for readers: entry n goes into slot
+// (n - 1) % slots, and its sequence is odd while the slot is rewritten and
+// 2n once it is complete. A reader checks the sequence before and after
+// reading a slot; if it changed, the writer lapped the reader and the data
+// must be thrown away
+typedef struct EXPORTHEADER_S
+{
+    char magic[8];
+    Sint32 slots;
+    Sint32 maxW; // Largest board a slot holds, in cells
+    Sint32 maxH;
+    Sint32 state;
+    Uint64 slotBytes; // Distance between slots, header included
+    Uint64 frequency; // Ticks per second of the slot timestamps
+    volatile Uint64 published; // Number of the newest complete entry, 0 before the first
+} ExportHeader;
+
+typedef struct EXPORTSLOT_S
+{
+    volatile Uint64 sequence;
+    Uint64 generation;
+    Uint64 ticks; // Performance counter when the entry was published
+    Sint32 universe; // Which universe of the window, 0 for a server
+    Sint32 w; // Size in cells
+    Sint32 h;
+    Sint32 stride; // Words in each row of cells, cells past w are dead
+    Sint32 wrap;
+    Sint32 unused;
+} ExportSlot;
+
+typedef struct EXPORT_S
+{
+    char name[256];
+    Uint8 *map;
+    size_t size;
+    ExportHeader *header;
+    Uint64 entries; // Entries published so far
+} Export;
+
+int openExport(Export *export, char *name, int w, int h, int slots);
+void publishBoard(Export *export, Board *board, int w, int h, int wrap, int universe, Uint64 generation);
+void closeExport(Export *export);
+
+#endif
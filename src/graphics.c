@@ -16,10 +16,14 @@
 // ###########################################################################
 
 #include "graphics.h"
+#include "assets.h"
 
-#define MAXSPRITES 50
+#define SPRITELISTSIZE 64 // Initial number of slots in the sprite hash table, must be a power of 2
+#define ATLASSIZE 1024 // Width and height of each atlas page
+#define ATLASPADDING 1 // Empty pixels between sprites in an atlas page
 #define DEFAULT_WINDOW_WIDTH 1024
 #define DEFAULT_WINDOW_HEIGHT 768
+#define DEFAULT_FPS 60
 
 SDL_Window *gWindow = NULL;
 SDL_Renderer *gRenderer = NULL;
@@ -27,8 +31,32 @@ int gQuit = 0;
 int gWinWidth;
 int gWinHeight;
 int spritesLoaded = 0;
+int gRedraw = 1; // Set when the next frame must be drawn even if the grid is unchanged
+int gDrawCalls = 0; // Copies issued to the renderer since the last HUD frame
 
-Sprite SpriteList[MAXSPRITES];
+// Open addressing hash table of loaded sprites, keyed by filename
+Sprite **SpriteList = NULL;
+int spriteListSize = 0;
+int spriteListFilled = 0; // Used slots including removed ones
+Sprite removedSprite; // Marks a slot whose sprite was freed
+
+// Shared textures that loaded sprites are packed into
+Atlas *AtlasPages = NULL;
+int atlasPageCount = 0;
+
+SDL_Texture *bgTexture = NULL; // Prebuilt window-sized copy of the tiled background
+Sprite *bgTextureSprite = NULL; // Tile the prebuilt background was built from
+int bgTextureDirty = 1; // Set when the prebuilt background must be rebuilt
+
+int gPacing = PACETIMER; // How nextFrame waits for the next frame
+int gTargetFps = DEFAULT_FPS; // Frame rate targeted by the timer pacing mode
+Uint64 frameDeadline = 0; // Performance counter value the current frame should end at
+Uint64 lastPresent = 0; // Performance counter value of the last present
+
+// Histogram of measured frame times, FRAMEHISTRES buckets per millisecond
+Uint32 frameHistogram[FRAMEHISTBUCKETS];
+Uint32 framesTimed = 0;
+Uint64 frameTimeTotal = 0;
 
 int initGraphics(char *windowTitle)
 {
@@ -45,7 +73,13 @@ int initGraphics(char *windowTitle)
         return 0;
     }
 
-    gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 flags = SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE;
+    if(gPacing == PACEVSYNC)
+    {
+        flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+
+    gRenderer = SDL_CreateRenderer(gWindow, -1, flags);
     if(gRenderer == NULL)
     {
         printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
@@ -72,94 +106,416 @@ void clearScreen()
     SDL_RenderClear(gRenderer);
 }
 
-void frameDelay(Uint32 delay)
+void setFramePacing(int mode, int fps)
+{
+    gPacing = mode;
+    gTargetFps = fps > 0 ? fps : DEFAULT_FPS;
+    frameDeadline = 0;
+
+    // Vsync can only be switched on an existing renderer with SDL 2.0.18 or later
+    if(gRenderer != NULL)
+    {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        SDL_RenderSetVSync(gRenderer, mode == PACEVSYNC);
+#endif
+    }
+}
+
+void frameDelay()
 {
-    static Uint32 pass = 100;
-    Uint32 diff = SDL_GetTicks() - pass;
-    if(diff < delay) SDL_Delay(delay - diff);
-    pass = SDL_GetTicks();
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 period = freq / gTargetFps;
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if(frameDeadline > now && frameDeadline - now <= period)
+    {
+        // Sleep until a millisecond before the deadline, then spin the rest
+        // of the way since SDL_Delay only has millisecond resolution
+        while(now < frameDeadline)
+        {
+            Uint64 remaining = (frameDeadline - now) * 1000 / freq;
+            if(remaining > 1)
+            {
+                SDL_Delay((Uint32)(remaining - 1));
+            }
+            now = SDL_GetPerformanceCounter();
+        }
+
+        frameDeadline += period;
+    }
+    else if(frameDeadline != 0 && frameDeadline <= now && now - frameDeadline < period)
+    {
+        // Slightly late, keep the cadence so one slow frame is not carried forward
+        frameDeadline += period;
+    }
+    else
+    {
+        // First frame, or too far behind (e.g. after idling), so start over
+        frameDeadline = now + period;
+    }
 }
 
 void nextFrame()
 {
     SDL_RenderPresent(gRenderer);
-    frameDelay(16); // 33 for 30 fps, 16 for 60 fps
+
+    if(gPacing == PACETIMER)
+    {
+        frameDelay();
+    }
+
+    recordFrameTime();
 }
 
-void initSpriteList()
+void recordFrameTime()
 {
-    for(int i = 0; i < MAXSPRITES; i++)
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 freq = SDL_GetPerformanceFrequency();
+
+    if(lastPresent != 0)
     {
-        SpriteList[i].image = NULL;
-        strncpy(SpriteList[i].filename, "", 64);
-        SpriteList[i].w = 0;
-        SpriteList[i].h = 0;
-        SpriteList[i].used = 0;
+        Uint64 elapsed = now - lastPresent;
+
+        // Gaps of over a second are idle time, not frames
+        if(elapsed < freq)
+        {
+            Uint64 bucket = elapsed * 1000 * FRAMEHISTRES / freq;
+            frameHistogram[bucket < FRAMEHISTBUCKETS ? bucket : FRAMEHISTBUCKETS - 1]++;
+            frameTimeTotal += elapsed;
+            framesTimed++;
+        }
     }
+
+    lastPresent = now;
 }
 
-Sprite* loadSprite(char *filename)
+double frameTimePercentile(double percent)
 {
-    SDL_Surface *loadedSurface = NULL;
+    Uint32 count = 0;
+    Uint32 target = (Uint32)(framesTimed * percent / 100.0);
 
-    for(int i = 0; i < MAXSPRITES; i++)
+    for(int i = 0; i < FRAMEHISTBUCKETS; i++)
     {
-        if(strncmp(filename, SpriteList[i].filename, 64) == 0)
+        count += frameHistogram[i];
+        if(count > target)
         {
-            return &SpriteList[i];
+            // Upper edge of the bucket in milliseconds
+            return (double)(i + 1) / FRAMEHISTRES;
         }
     }
 
-    for(int i = 0; i < MAXSPRITES; i++)
+    return (double)FRAMEHISTBUCKETS / FRAMEHISTRES;
+}
+
+void printFrameStats()
+{
+    if(framesTimed == 0)
+    {
+        printf("No frames timed\n");
+        return;
+    }
+
+    double mean = (double)frameTimeTotal * 1000.0 / SDL_GetPerformanceFrequency() / framesTimed;
+
+    printf("Frame pacing: %s, target %i fps\n", gPacing == PACEVSYNC ? "vsync" : "timer", gTargetFps);
+    printf("Frames: %u  mean: %.2f ms (%.1f fps)  p50: %.2f ms  p99: %.2f ms\n",
+        framesTimed, mean, 1000.0 / mean, frameTimePercentile(50.0), frameTimePercentile(99.0));
+
+    for(int i = 0; i < FRAMEHISTBUCKETS; i++)
     {
-        if(!SpriteList[i].used)
+        if(frameHistogram[i] > 0)
         {
-            loadedSurface = IMG_Load(filename);
-            if(loadedSurface == NULL)
-            {
-                printf("Unable to load image %s! SDL_image Error: %s\n", filename, IMG_GetError());
-                return NULL;
-            }
+            printf("%s%6.2f ms: %u\n", i == FRAMEHISTBUCKETS - 1 ? ">=" : "< ", (double)i / FRAMEHISTRES + (i == FRAMEHISTBUCKETS - 1 ? 0 : 1.0 / FRAMEHISTRES), frameHistogram[i]);
+        }
+    }
+}
+
+void initSpriteList()
+{
+    SpriteList = calloc(SPRITELISTSIZE, sizeof(Sprite*));
+    spriteListSize = SpriteList != NULL ? SPRITELISTSIZE : 0;
+    spriteListFilled = 0;
+    spritesLoaded = 0;
+}
+
+Uint32 hashFilename(char *filename)
+{
+    // FNV-1a
+    Uint32 hash = 2166136261u;
+
+    while(*filename)
+    {
+        hash ^= (Uint8)*filename++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+int findSpriteSlot(char *filename)
+{
+    int mask = spriteListSize - 1;
+    int slot = hashFilename(filename) & mask;
+    int freeSlot = -1;
 
-            SpriteList[i].image = SDL_CreateTextureFromSurface(gRenderer, loadedSurface);
-            SDL_FreeSurface(loadedSurface);
-            loadedSurface = NULL;
-            if(SpriteList[i].image == NULL)
+    // Return the slot holding filename, or else the first reusable slot
+    while(SpriteList[slot] != NULL)
+    {
+        if(SpriteList[slot] == &removedSprite)
+        {
+            if(freeSlot < 0)
             {
-                printf("Unable to create texture from %s! SDL Error: %s\n", filename, SDL_GetError());
-                return NULL;
+                freeSlot = slot;
             }
+        }
+        else if(strcmp(SpriteList[slot]->filename, filename) == 0)
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return freeSlot >= 0 ? freeSlot : slot;
+}
+
+int growSpriteList()
+{
+    Sprite **oldList = SpriteList;
+    int oldSize = spriteListSize;
+
+    SpriteList = calloc(oldSize * 2, sizeof(Sprite*));
+    if(SpriteList == NULL)
+    {
+        SpriteList = oldList;
+        return 0;
+    }
+
+    spriteListSize = oldSize * 2;
+    spriteListFilled = 0;
+
+    for(int i = 0; i < oldSize; i++)
+    {
+        if(oldList[i] != NULL && oldList[i] != &removedSprite)
+        {
+            SpriteList[findSpriteSlot(oldList[i]->filename)] = oldList[i];
+            spriteListFilled++;
+        }
+    }
+
+    free(oldList);
+
+    return 1;
+}
+
+Atlas* addAtlasPage(int w, int h)
+{
+    Atlas *pages = realloc(AtlasPages, (atlasPageCount + 1) * sizeof(Atlas));
+    if(pages == NULL)
+    {
+        return NULL;
+    }
+    AtlasPages = pages;
+
+    Atlas *page = &AtlasPages[atlasPageCount];
+    page->texture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+    if(page->texture == NULL)
+    {
+        printf("Unable to create atlas texture! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_SetTextureBlendMode(page->texture, SDL_BLENDMODE_BLEND);
+
+    // Clear the page so padding between sprites stays transparent
+    Uint32 *blank = calloc(w * h, sizeof(Uint32));
+    if(blank != NULL)
+    {
+        SDL_UpdateTexture(page->texture, NULL, blank, w * sizeof(Uint32));
+        free(blank);
+    }
+
+    page->w = w;
+    page->h = h;
+    page->shelfX = 0;
+    page->shelfY = 0;
+    page->shelfH = 0;
+
+    atlasPageCount++;
 
-            strncpy(SpriteList[i].filename, filename, 64);
-	        SDL_QueryTexture(SpriteList[i].image, NULL, NULL, &SpriteList[i].w, &SpriteList[i].h);
-            SpriteList[i].used = 1;
+    return page;
+}
+
+int packSprite(Sprite *sprite, SDL_Surface *surface)
+{
+    Atlas *page = atlasPageCount > 0 ? &AtlasPages[atlasPageCount - 1] : NULL;
+    int w = surface->w + ATLASPADDING;
+    int h = surface->h + ATLASPADDING;
 
-            spritesLoaded++;
-            //printf("Sprites loaded: %i\n", spritesLoaded);
+    if(page != NULL)
+    {
+        // Start a new shelf if the sprite does not fit on the current one
+        if(page->shelfX + w > page->w)
+        {
+            page->shelfX = 0;
+            page->shelfY += page->shelfH;
+            page->shelfH = 0;
+        }
 
-            return &SpriteList[i];
+        if(page->shelfY + h > page->h)
+        {
+            page = NULL;
         }
     }
 
-    printf("Error: Sprite limit reached");
+    // Open a new page once the current one is full
+    if(page == NULL)
+    {
+        page = addAtlasPage(w > ATLASSIZE ? w : ATLASSIZE, h > ATLASSIZE ? h : ATLASSIZE);
+        if(page == NULL)
+        {
+            return 0;
+        }
+    }
+
+    sprite->src.x = page->shelfX;
+    sprite->src.y = page->shelfY;
+    sprite->src.w = surface->w;
+    sprite->src.h = surface->h;
+    sprite->image = page->texture;
+
+    if(SDL_UpdateTexture(page->texture, &sprite->src, surface->pixels, surface->pitch) < 0)
+    {
+        printf("Unable to update atlas texture! SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    page->shelfX += w;
+    if(h > page->shelfH)
+    {
+        page->shelfH = h;
+    }
+
+    return 1;
+}
+
+Sprite* findSprite(char *name)
+{
+    if(SpriteList == NULL)
+    {
+        return NULL;
+    }
+
+    int slot = findSpriteSlot(name);
+    if(SpriteList[slot] != NULL && SpriteList[slot] != &removedSprite)
+    {
+        return SpriteList[slot];
+    }
+
     return NULL;
 }
 
+Sprite* createSprite(char *name, SDL_Surface *surface)
+{
+    SDL_Surface *convertedSurface = NULL;
+
+    if(SpriteList == NULL)
+    {
+        printf("Error: Sprite list is not initialized\n");
+        return NULL;
+    }
+
+    convertedSurface = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if(convertedSurface == NULL)
+    {
+        printf("Unable to convert image %s! SDL Error: %s\n", name, SDL_GetError());
+        return NULL;
+    }
+
+    Sprite *sprite = calloc(1, sizeof(Sprite));
+    if(sprite == NULL || (sprite->filename = strdup(name)) == NULL)
+    {
+        printf("Error: Out of memory loading %s\n", name);
+        free(sprite);
+        SDL_FreeSurface(convertedSurface);
+        return NULL;
+    }
+
+    if(!packSprite(sprite, convertedSurface))
+    {
+        printf("Unable to pack %s into the sprite atlas!\n", name);
+        free(sprite->filename);
+        free(sprite);
+        SDL_FreeSurface(convertedSurface);
+        return NULL;
+    }
+
+    sprite->w = convertedSurface->w;
+    sprite->h = convertedSurface->h;
+    sprite->used = 1;
+    SDL_FreeSurface(convertedSurface);
+    convertedSurface = NULL;
+
+    // Keep the table at most 3/4 full so probe sequences stay short
+    int slot = findSpriteSlot(name);
+    if(SpriteList[slot] == NULL)
+    {
+        spriteListFilled++;
+    }
+    SpriteList[slot] = sprite;
+
+    if(spriteListFilled * 4 > spriteListSize * 3)
+    {
+        growSpriteList();
+    }
+
+    spritesLoaded++;
+    //printf("Sprites loaded: %i\n", spritesLoaded);
+
+    return sprite;
+}
+
+Sprite* loadSprite(char *filename)
+{
+    Sprite *sprite = findSprite(filename);
+    if(sprite != NULL)
+    {
+        return sprite;
+    }
+
+    // Images are embedded in the executable, the disk is only a fallback
+    SDL_Surface *loadedSurface = loadAssetSurface(filename);
+    if(loadedSurface == NULL)
+    {
+        printf("Unable to load image %s! SDL_image Error: %s\n", filename, IMG_GetError());
+        return NULL;
+    }
+
+    sprite = createSprite(filename, loadedSurface);
+    SDL_FreeSurface(loadedSurface);
+
+    return sprite;
+}
+
 void freeSprite(Sprite *sprite)
 {
-    if(sprite->image != NULL)
+    if(sprite == NULL || !sprite->used)
     {
-        SDL_DestroyTexture(sprite->image);
-        sprite->image = NULL;
+        return;
+    }
 
-        spritesLoaded--;
-        //printf("Sprites loaded: %i\n", spritesLoaded);
+    // The sprite's space in its atlas page is reclaimed in closeGraphics
+    int slot = findSpriteSlot(sprite->filename);
+    if(SpriteList[slot] == sprite)
+    {
+        SpriteList[slot] = &removedSprite;
     }
 
-    strncpy(sprite->filename, "", 64);
-    sprite->w = 0;
-    sprite->h = 0;
-    sprite->used = 0;
+    spritesLoaded--;
+    //printf("Sprites loaded: %i\n", spritesLoaded);
+
+    free(sprite->filename);
+    free(sprite);
 }
 
 void drawSprite(Sprite *sprite, int x, int y, double rot, SDL_RendererFlip flip)
@@ -178,18 +534,58 @@ void drawSprite(Sprite *sprite, int x, int y, double rot, SDL_RendererFlip flip)
     dest.w = sprite->w;
     dest.h = sprite->h;
 
-    SDL_RenderCopyEx(gRenderer, sprite->image, NULL, &dest, rot, NULL, flip);
+    SDL_RenderCopyEx(gRenderer, sprite->image, &sprite->src, &dest, rot, NULL, flip);
+    gDrawCalls++;
 }
 
-void drawBackground(Sprite *sprite)
+void drawSpriteScaled(Sprite *sprite, SDL_Rect *dest)
 {
     if(sprite == NULL)
     {
-        printf("Tried to draw bg that was null! SDL Error: %s\n", SDL_GetError());
+        printf("Tried to draw sprite that was null! SDL Error: %s\n", SDL_GetError());
         gQuit = 1;
         return;
     }
 
+    SDL_RenderCopy(gRenderer, sprite->image, &sprite->src, dest);
+    gDrawCalls++;
+}
+
+int buildBackground(Sprite *sprite)
+{
+    if(bgTexture != NULL)
+    {
+        SDL_DestroyTexture(bgTexture);
+        bgTexture = NULL;
+    }
+
+    bgTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, gWinWidth, gWinHeight);
+    if(bgTexture == NULL)
+    {
+        printf("Unable to create background texture! SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    // Tile the sprite once into the texture instead of on every frame
+    SDL_Texture *target = SDL_GetRenderTarget(gRenderer);
+    SDL_SetRenderTarget(gRenderer, bgTexture);
+    SDL_RenderClear(gRenderer);
+    drawTiles(sprite);
+    SDL_SetRenderTarget(gRenderer, target);
+
+    bgTextureSprite = sprite;
+    bgTextureDirty = 0;
+
+    return 1;
+}
+
+void invalidateBackground()
+{
+    bgTextureDirty = 1;
+}
+
+void drawTiles(Sprite *sprite)
+{
     int xTiles = 1 + (gWinWidth / sprite->w);
     int yTiles = 1 + (gWinHeight / sprite->h);
 
@@ -201,6 +597,35 @@ void drawBackground(Sprite *sprite)
     }
 }
 
+void drawBackground(Sprite *sprite)
+{
+    if(sprite == NULL)
+    {
+        printf("Tried to draw bg that was null! SDL Error: %s\n", SDL_GetError());
+        gQuit = 1;
+        return;
+    }
+
+    // Rebuild the prebuilt background after a resize or if the tile changed
+    if(bgTextureDirty || bgTexture == NULL || bgTextureSprite != sprite)
+    {
+        if(!buildBackground(sprite))
+        {
+            // Fall back to tiling directly if render targets are unavailable
+            drawTiles(sprite);
+            return;
+        }
+    }
+
+    SDL_RenderCopy(gRenderer, bgTexture, NULL, NULL);
+    gDrawCalls++;
+}
+
+void requestRedraw()
+{
+    gRedraw = 1;
+}
+
 int checkWindowSize()
 {
     int width;
@@ -213,6 +638,8 @@ int checkWindowSize()
         // set globals and return 1 if window has been resized
         gWinWidth = width;
         gWinHeight = height;
+        invalidateBackground();
+        requestRedraw();
         return 1;
     }
 
@@ -221,10 +648,34 @@ int checkWindowSize()
 
 void closeGraphics()
 {
-    for(int i = 0; i < MAXSPRITES; i++)
+    for(int i = 0; i < spriteListSize; i++)
+    {
+        if(SpriteList[i] != NULL && SpriteList[i] != &removedSprite)
+        {
+            freeSprite(SpriteList[i]);
+        }
+    }
+
+    free(SpriteList);
+    SpriteList = NULL;
+    spriteListSize = 0;
+    spriteListFilled = 0;
+
+    for(int i = 0; i < atlasPageCount; i++)
+    {
+        SDL_DestroyTexture(AtlasPages[i].texture);
+    }
+
+    free(AtlasPages);
+    AtlasPages = NULL;
+    atlasPageCount = 0;
+
+    if(bgTexture != NULL)
     {
-        freeSprite(&SpriteList[i]);
+        SDL_DestroyTexture(bgTexture);
+        bgTexture = NULL;
     }
+    bgTextureSprite = NULL;
 
     if(gRenderer != NULL)
     {
@@ -21,24 +21,60 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
+#define FRAMEHISTBUCKETS 1000 // Frame time histogram covers 0 to 250 ms, so frames held up by stepping still show where they land
+#define FRAMEHISTRES 4 // Frame time histogram buckets per millisecond
+
+enum PACINGMODE
+{
+    PACETIMER = 0,
+    PACEVSYNC = 1
+};
+
 typedef struct SPRITE_S
 {
-    SDL_Texture *image;
-    char filename[64];
+    SDL_Texture *image; // Atlas page that holds the sprite
+    SDL_Rect src; // Location of the sprite within its atlas page
+    char *filename;
     int w;
     int h;
     int used;
 } Sprite;
 
+typedef struct ATLAS_S
+{
+    SDL_Texture *texture;
+    int w;
+    int h;
+    int shelfX; // Next free position on the current shelf
+    int shelfY;
+    int shelfH; // Height of the tallest sprite on the current shelf
+} Atlas;
+
 int initGraphics(char *windowTitle);
 void clearScreen();
-void frameDelay(Uint32 delay);
+void setFramePacing(int mode, int fps);
+void frameDelay();
 void nextFrame();
+void recordFrameTime();
+double frameTimePercentile(double percent);
+void printFrameStats();
 void initSpriteList();
+Uint32 hashFilename(char *filename);
+int findSpriteSlot(char *filename);
+int growSpriteList();
+Atlas* addAtlasPage(int w, int h);
+int packSprite(Sprite *sprite, SDL_Surface *surface);
+Sprite* findSprite(char *name);
+Sprite* createSprite(char *name, SDL_Surface *surface);
 Sprite* loadSprite(char *filename);
 void freeSprite(Sprite *sprite);
 void drawSprite(Sprite *sprite, int x, int y, double rot, SDL_RendererFlip flip);
+void drawSpriteScaled(Sprite *sprite, SDL_Rect *dest);
+int buildBackground(Sprite *sprite);
+void invalidateBackground();
+void drawTiles(Sprite *sprite);
 void drawBackground(Sprite *sprite);
+void requestRedraw();
 int checkWindowSize();
 void closeGraphics();
 
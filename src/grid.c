@@ -14,37 +14,99 @@
 //    any later version.
 // ###########################################################################
 
+#include <math.h>
 #include "grid.h"
 #include "input.h"
+#include "camera.h"
+#include "hud.h"
+#include "led.h"
+#include "engine.h"
+#include "patterns.h"
 
 #define MAXCELLSX 550
 #define MAXCELLSY 550
 #define CELLSPACINGX 2
 #define CELLSPACINGY 2
+#define LEDMINPITCH 6.0 // Below this many pixels per cell, cells are drawn as flat pixels
+#define MIPLEVELS 4 // Number of density-averaged levels below one pixel per cell
+#define MIPSIZEX ((MAXCELLSX + (1 << MIPLEVELS)) / 2)
+#define MIPSIZEY ((MAXCELLSY + (1 << MIPLEVELS)) / 2)
+#define FUSEDCHECKS 3 // Universes stepped together by checkFusedRender
+#define LABELOFFSET 12 // Pixels between the mouse pointer or a selection and its label
 
+// renderBand builds whole texels from the rows of one band, so a band has to
+// cover whole texels at every mip level. Fails to compile otherwise
+typedef char bandsAlign[(BANDROWS % (1 << MIPLEVELS)) == 0 ? 1 : -1];
+
+extern SDL_Renderer *gRenderer;
 extern int gWinWidth;
 extern int gWinHeight;
 extern int gQuit;
+extern int gDrawCalls;
+extern int gMouseX;
+extern int gMouseY;
+extern Camera gCamera;
+extern Engine *gEngine;
+extern Pattern *gStampPattern;
+extern int gStampOrientation;
+extern SDL_Rect gSelection;
+extern int gFillDensity;
+extern int gClientMode;
+extern int gRemoteWidth;
+extern int gRemoteHeight;
+
+#define PANEGAP 4 // Pixels between the panes of neighbouring universes
 
 Sprite *deadSprite = NULL;
-Sprite *redSprite = NULL;
-Sprite *greenSprite = NULL;
-Sprite *blueSprite = NULL;
-Sprite *purpleSprite = NULL;
-Sprite *yellowSprite = NULL;
+Sprite *liveSprites[RANDOMCELL]; // Live cell sprite for each palette entry
 Sprite *highlightSprite = NULL;
 
-int gLoopEdges = 0; // Edge looping needs refinement, disabled for now
-int gGridColor = REDCELL; // Default grid color is red
-int gPlay = 0; // Game is stopped by default on launch
-int gSpeed = SPD3; // Default speed is 3
 int gCellSize = SMALL; // Default cell size is small
+int gFusedRender = 0; // Build the pixels of the visible region while stepping
+
+Universe Universes[MAXUNIVERSES];
+int universeCount = 0;
+Universe *gUniverse = NULL; // Universe the buttons, keys and mouse act on
+
+// Cell colors used when the grid is drawn as flat pixels (averages of the LED sprites)
+Uint32 paletteColors[] = { 0xFFB70605, 0xFF0AA902, 0xFF3253B3, 0xFF8E0195, 0xFFA0AF02, 0xFF6D5643 };
+Uint32 deadColor = 0xFF241813;
 
-Cell CurrentGrid[MAXCELLSX][MAXCELLSY];
-Cell NextGrid[MAXCELLSX][MAXCELLSY];
+// Density pyramid for far zoom levels, level n averages 2^n x 2^n cells
+Uint8 MipLevels[MIPLEVELS][MIPSIZEX][MIPSIZEY];
 
-int gridSizeX;
-int gridSizeY;
+// Every generation stepped is published here when exporting
+Export universeExport;
+
+// Pixels of the visible part of a universe, shared by all of them since they are drawn one at a time
+Uint32 lodPixels[MAXCELLSX * MAXCELLSY];
+
+void initUniverses(int count, int *densities)
+{
+    universeCount = count < 1 ? 1 : count > MAXUNIVERSES ? MAXUNIVERSES : count;
+
+    for(int i = 0; i < universeCount; i++)
+    {
+        Universe *universe = &Universes[i];
+
+        universe->wrap = 0; // Edges are dead by default
+        universe->color = REDCELL; // Default grid color is red
+        universe->stroke = 0;
+        universe->play = 0; // Game is stopped by default on launch
+        universe->speed = SPD3; // Default speed is 3
+        universe->density = densities != NULL ? densities[i] : 50;
+        universe->version = 0;
+        universe->generation = 0;
+        universe->lodTexture = NULL;
+        universe->lodLevel = -1;
+        universe->lodVersion = -1;
+        universe->lodColor = -1;
+        universe->fusedPixels = NULL;
+        universe->fusedVersion = -1;
+    }
+
+    gUniverse = &Universes[0];
+}
 
 void initGrid()
 {
@@ -55,23 +117,43 @@ void initGrid()
         return;
     }
 
-    for(int x = 0; x < MAXCELLSX; x++)
+    if(universeCount == 0)
     {
-        for(int y = 0; y < MAXCELLSY; y++)
+        initUniverses(1, NULL);
+    }
+
+    for(int i = 0; i < universeCount; i++)
+    {
+        Universe *universe = &Universes[i];
+
+        if(universe->current == NULL)
         {
-            CurrentGrid[x][y].sprite[0] = deadSprite;
-            CurrentGrid[x][y].box.w = CurrentGrid[x][y].sprite[0]->w;
-            CurrentGrid[x][y].box.h = CurrentGrid[x][y].sprite[0]->h;
-            CurrentGrid[x][y].box.x = (CELLSPACINGX * (x+1)) + (CurrentGrid[x][y].box.w * x);
-            CurrentGrid[x][y].box.y = (CELLSPACINGY * (y+1)) + (CurrentGrid[x][y].box.h * y);
-            CurrentGrid[x][y].alive = rand() % 2;
+            universe->current = createBoard(MAXCELLSX, MAXCELLSY);
+            universe->next = createBoard(MAXCELLSX, MAXCELLSY);
+            universe->colors = malloc(MAXCELLSX * MAXCELLSY);
+            if(universe->current == NULL || universe->next == NULL || universe->colors == NULL)
+            {
+                gQuit = 1;
+                return;
+            }
+        }
+
+        randomizeUniverse(universe);
+
+        // History starts from the first random board
+        if(universe->journal.shadow == NULL && !gClientMode && !initJournal(&universe->journal, universe->current))
+        {
+            gQuit = 1;
+            return;
         }
-    }
 
-    memcpy(NextGrid, CurrentGrid, sizeof(CurrentGrid));
+        if(universe->color == RANDOMCELL)
+        {
+            fillRandomColors(universe);
+        }
+    }
 
     resizeGrid();
-    setGridColor(gGridColor);
 }
 
 int loadGridSprites()
@@ -79,27 +161,27 @@ int loadGridSprites()
     if(gCellSize == LARGE)
     {
         deadSprite = loadSprite("images/ledOffLG.png");
-        redSprite = loadSprite("images/ledRedLG.png");
-        greenSprite = loadSprite("images/ledGreenLG.png");
-        blueSprite = loadSprite("images/ledBlueLG.png");
-        purpleSprite = loadSprite("images/ledPurpleLG.png");
-        yellowSprite = loadSprite("images/ledYellowLG.png");
+        liveSprites[REDCELL] = loadSprite("images/ledRedLG.png");
+        liveSprites[GREENCELL] = loadSprite("images/ledGreenLG.png");
+        liveSprites[BLUECELL] = loadSprite("images/ledBlueLG.png");
+        liveSprites[PURPLECELL] = loadSprite("images/ledPurpleLG.png");
+        liveSprites[YELLOWCELL] = loadSprite("images/ledYellowLG.png");
         highlightSprite = loadSprite("images/ledHighlightLG.png");
     }
     else
     {
         deadSprite = loadSprite("images/ledOff.png");
-        redSprite = loadSprite("images/ledRed.png");
-        greenSprite = loadSprite("images/ledGreen.png");
-        blueSprite = loadSprite("images/ledBlue.png");
-        purpleSprite = loadSprite("images/ledPurple.png");
-        yellowSprite = loadSprite("images/ledYellow.png");
+        liveSprites[REDCELL] = loadSprite("images/ledRed.png");
+        liveSprites[GREENCELL] = loadSprite("images/ledGreen.png");
+        liveSprites[BLUECELL] = loadSprite("images/ledBlue.png");
+        liveSprites[PURPLECELL] = loadSprite("images/ledPurple.png");
+        liveSprites[YELLOWCELL] = loadSprite("images/ledYellow.png");
         highlightSprite = loadSprite("images/ledHighlight.png");
     }
 
     // Return 1 if there is a problem loading any of the grid sprites
-    if(deadSprite == NULL || redSprite == NULL || greenSprite == NULL || blueSprite == NULL
-    || purpleSprite == NULL || yellowSprite == NULL || highlightSprite == NULL)
+    if(deadSprite == NULL || liveSprites[REDCELL] == NULL || liveSprites[GREENCELL] == NULL || liveSprites[BLUECELL] == NULL
+    || liveSprites[PURPLECELL] == NULL || liveSprites[YELLOWCELL] == NULL || highlightSprite == NULL)
     {
         return 1;
     }
@@ -113,189 +195,1103 @@ void resizeGrid()
 {
     if(deadSprite != NULL)
     {
-        gridSizeX = gWinWidth / (deadSprite->w + CELLSPACINGX);
-        if(gridSizeX > MAXCELLSX)
+        int pitch = deadSprite->w + CELLSPACINGX;
+
+        // The bottom of the window is reserved for the buttons, the rest is
+        // split into panes two across, one for each universe
+        int columns = universeCount > 1 ? 2 : 1;
+        int rows = (universeCount + columns - 1) / columns;
+        int paneW = (gWinWidth - (columns - 1) * PANEGAP) / columns;
+        int paneH = (gWinHeight - (gCellSize * (deadSprite->h + CELLSPACINGY)) - (rows - 1) * PANEGAP) / rows;
+
+        // Every pane shows the same cells of its universe
+        setCameraView(pitch, paneW, paneH);
+
+        // The universe keeps its size whatever the window or camera show of it,
+        // so how it is looked at never changes how it evolves
+        int w = MAXCELLSX;
+        int h = MAXCELLSY;
+
+        // A viewer shows as much of the server's universe as fits in the grid
+        if(gClientMode)
         {
-            gridSizeX = MAXCELLSX;
+            w = gRemoteWidth < MAXCELLSX ? gRemoteWidth : MAXCELLSX;
+            h = gRemoteHeight < MAXCELLSY ? gRemoteHeight : MAXCELLSY;
         }
 
-        gridSizeY = (gWinHeight / (deadSprite->h + CELLSPACINGY)) - gCellSize;
-        if(gridSizeY > MAXCELLSY)
+        for(int i = 0; i < universeCount; i++)
         {
-            gridSizeY = MAXCELLSY;
+            Universe *universe = &Universes[i];
+
+            universe->w = w;
+            universe->h = h;
+            universe->pane.x = (i % columns) * (paneW + PANEGAP);
+            universe->pane.y = (i / columns) * (paneH + PANEGAP);
+            universe->pane.w = paneW;
+            universe->pane.h = paneH;
+            universe->version++;
         }
+
+        clampCamera();
     }
 }
 
 void clearGrid()
 {
-    for(int x = 0; x < MAXCELLSX; x++)
+    for(int i = 0; i < universeCount; i++)
     {
-        for(int y = 0; y < MAXCELLSY; y++)
+        Universe *universe = &Universes[i];
+
+        freeBoard(universe->current);
+        freeBoard(universe->next);
+        free(universe->colors);
+        universe->current = NULL;
+        universe->next = NULL;
+        universe->colors = NULL;
+        closeJournal(&universe->journal);
+        free(universe->fusedPixels);
+        universe->fusedPixels = NULL;
+
+        if(universe->lodTexture != NULL)
         {
-            CurrentGrid[x][y].sprite[0] = NULL;
-            CurrentGrid[x][y].sprite[1] = NULL;
-            CurrentGrid[x][y].alive = 0;
+            SDL_DestroyTexture(universe->lodTexture);
+            universe->lodTexture = NULL;
         }
     }
 
-    memcpy(NextGrid, CurrentGrid, sizeof(CurrentGrid));
+    closeExport(&universeExport);
 
     deadSprite = NULL;
-    redSprite = NULL;
-    greenSprite = NULL;
-    blueSprite = NULL;
-    purpleSprite = NULL;
-    yellowSprite = NULL;
+    liveSprites[REDCELL] = NULL;
+    liveSprites[GREENCELL] = NULL;
+    liveSprites[BLUECELL] = NULL;
+    liveSprites[PURPLECELL] = NULL;
+    liveSprites[YELLOWCELL] = NULL;
     highlightSprite = NULL;
 }
 
-void clearCells()
+void clearCells(Universe *universe)
+{
+    if(gClientMode)
+    {
+        return;
+    }
+
+    journalUniverse(universe);
+    clearBoard(universe->current);
+    clearBoard(universe->next);
+    journalUniverse(universe);
+    universe->version++;
+}
+
+void randomizeUniverse(Universe *universe)
+{
+    // A viewer's cells belong to the server
+    if(gClientMode)
+    {
+        return;
+    }
+
+    journalUniverse(universe);
+    fillBoardRegion(universe->current, 0, 0, MAXCELLSX, MAXCELLSY, universe->density, ((Uint64)rand() << 32) ^ (Uint64)rand());
+    copyBoard(universe->next, universe->current);
+    journalUniverse(universe);
+    universe->version++;
+}
+
+void journalUniverse(Universe *universe)
+{
+    // Edits are journaled before (to keep generations stepped since the last
+    // entry apart) and after, a viewer's cells belong to the server
+    if(!gClientMode)
+    {
+        commitJournal(&universe->journal, universe->current);
+    }
+}
+
+int undoEdit(Universe *universe)
+{
+    if(gClientMode || !undoJournal(&universe->journal, universe->current))
+    {
+        return 0;
+    }
+
+    // Cells outside the grid are kept the same in both boards
+    copyBoard(universe->next, universe->current);
+    universe->version++;
+
+    return 1;
+}
+
+int redoEdit(Universe *universe)
 {
-    for(int x = 0; x < MAXCELLSX; x++)
+    if(gClientMode || !redoJournal(&universe->journal, universe->current))
     {
-        for(int y = 0; y < MAXCELLSY; y++)
+        return 0;
+    }
+
+    copyBoard(universe->next, universe->current);
+    universe->version++;
+
+    return 1;
+}
+
+void focusUniverse(Universe *universe)
+{
+    if(universe != NULL && universe != gUniverse)
+    {
+        // Selections and strokes belong to the universe they were started in
+        gUniverse = universe;
+        gSelection.w = 0;
+        requestRedraw();
+    }
+}
+
+Universe* universeAt(int x, int y)
+{
+    for(int i = 0; i < universeCount; i++)
+    {
+        SDL_Rect *pane = &Universes[i].pane;
+
+        if(x >= pane->x && y >= pane->y && x < pane->x + pane->w && y < pane->y + pane->h)
         {
-            CurrentGrid[x][y].alive = 0;
+            return &Universes[i];
         }
     }
 
-    memcpy(NextGrid, CurrentGrid, sizeof(CurrentGrid));
+    return NULL;
 }
 
-void updateGrid()
+int universesPlaying()
 {
-    for(int y = 0; y < gridSizeY; y++)
+    for(int i = 0; i < universeCount; i++)
     {
-        for(int x = 0; x < gridSizeX; x++)
+        if(Universes[i].play)
         {
-            int n = countLiveNeighbors(x, y);
-            int c = CurrentGrid[x][y].alive;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int gridVersion()
+{
+    // Changes whenever any universe changes
+    int version = 0;
+
+    for(int i = 0; i < universeCount; i++)
+    {
+        version += Universes[i].version;
+    }
 
-            // A live cell dies unless it has exactly 2 or 3 live neighbors
-            // A dead cell remains dead unless it has exactly 3 live neighbors
-            NextGrid[x][y].alive = (c && (n == 2 || n == 3)) || (!c && n == 3);
+    return version;
+}
+
+void updateGrid(Universe *universe)
+{
+    // Viewers get their generations from the server
+    if(gClientMode)
+    {
+        return;
+    }
+
+    Uint64 start = hudTimer();
+
+    stepBoard(gEngine, universe->current, universe->next, universe->w, universe->h, universe->wrap);
+    swapUniverse(universe);
+
+    hudAddSim(start);
+    hudAddGeneration();
+}
+
+void stepUniverses()
+{
+    if(gClientMode)
+    {
+        return;
+    }
+
+    StepJob jobs[MAXUNIVERSES];
+    Universe *stepped[MAXUNIVERSES];
+    int count = 0;
+    Uint32 now = SDL_GetTicks();
+
+    // Each universe steps at its own speed, those that are due step together.
+    // Nothing waits here, nextFrame paces the loop and the rest just draw
+    for(int i = 0; i < universeCount; i++)
+    {
+        Universe *universe = &Universes[i];
+
+        if(!universe->play)
+        {
+            continue;
+        }
+
+        if((Sint32)(now - universe->due) >= 0)
+        {
+            StepJob job = { gEngine, universe->current, universe->next, universe->w, universe->h, universe->wrap, NULL, NULL };
+
+            if(gFusedRender)
+            {
+                fuseUniverse(universe, &job);
+            }
+
+            jobs[count] = job;
+            stepped[count++] = universe;
+
+            // Keep the cadence of the deadlines unless too far behind (e.g. just started playing)
+            universe->due = (Sint32)(now - universe->due) < universe->speed ? universe->due + universe->speed : now + universe->speed;
         }
     }
 
-    // Copy next grid to current grid
-    memcpy(CurrentGrid, NextGrid, sizeof(CurrentGrid));
+    if(count > 0)
+    {
+        Uint64 start = hudTimer();
+
+        stepBoards(gEngine, jobs, count);
+
+        for(int i = 0; i < count; i++)
+        {
+            swapUniverse(stepped[i]);
+            hudAddGeneration();
 
-    // Delay based on gSpeed if playing
-    if(gPlay)
+            // The pixels built while stepping show the generation just swapped in
+            if(jobs[i].bandDone != NULL)
+            {
+                stepped[i]->fusedVersion = stepped[i]->version;
+            }
+        }
+
+        hudAddSim(start);
+    }
+}
+
+void swapUniverse(Universe *universe)
+{
+    // Swap the next grid in rather than copying it
+    Board *swap = universe->current;
+    universe->current = universe->next;
+    universe->next = swap;
+    universe->version++;
+    universe->generation++;
+
+    publishBoard(&universeExport, universe->current, universe->w, universe->h, universe->wrap, (int)(universe - Universes),
+                 universe->generation);
+}
+
+int exportUniverses(char *name, int slots)
+{
+    return openExport(&universeExport, name, MAXCELLSX, MAXCELLSY, slots);
+}
+
+int fuseUniverse(Universe *universe, StepJob *job)
+{
+    // LEDs are only drawn for the few cells of a close zoom, there is nothing to gain there
+    int level = drawLevel();
+    SDL_Rect region;
+
+    if(level < 0 || !levelRegion(&region, level))
+    {
+        return 0;
+    }
+
+    if(universe->fusedPixels == NULL)
     {
-        SDL_Delay(gSpeed);
+        universe->fusedPixels = malloc(sizeof(Uint32) * MAXCELLSX * MAXCELLSY);
+        if(universe->fusedPixels == NULL)
+        {
+            printf("Unable to allocate fused render pixels!\n");
+            gFusedRender = 0;
+            return 0;
+        }
     }
+
+    universe->fusedRect = region;
+    universe->fusedLevel = level;
+    universe->fusedColor = universe->color;
+    universe->fusedVersion = -1;
+
+    for(int i = 0; i < 256; i++)
+    {
+        universe->fusedShades[i] = blendColor(deadColor, paletteColors[universe->color], i);
+    }
+
+    job->bandDone = renderBand;
+    job->bandData = universe;
+
+    return 1;
 }
 
-void drawGrid()
+void renderBand(StepJob *job, int y0, int y1)
 {
-    for(int x = 0; x < gridSizeX; x++)
+    Universe *universe = job->bandData;
+    SDL_Rect *region = &universe->fusedRect;
+    int level = universe->fusedLevel;
+    int step = 1 << level;
+    Uint32 *shades = universe->fusedShades;
+
+    // Texel rows whose cells start in this band. Bands are a multiple of
+    // 1 << MIPLEVELS rows, so no texel needs rows another worker is stepping
+    int ty0 = (y0 + step - 1) >> level;
+    int ty1 = (y1 + step - 1) >> level;
+
+    if(ty0 < region->y) ty0 = region->y;
+    if(ty1 > region->y + region->h) ty1 = region->y + region->h;
+
+    for(int ty = ty0; ty < ty1; ty++)
     {
-        for(int y = 0; y < gridSizeY; y++)
+        Uint32 *row = &universe->fusedPixels[(ty - region->y) * region->w];
+
+        for(int tx = 0; tx < region->w; tx++)
         {
-            drawSprite(CurrentGrid[x][y].sprite[CurrentGrid[x][y].alive], CurrentGrid[x][y].box.x, CurrentGrid[x][y].box.y, 0, SDL_FLIP_NONE);
+            int x = region->x + tx;
 
-            if(!gPlay && mouseCollide(&CurrentGrid[x][y].box))
+            if(level > 0)
+            {
+                row[tx] = shades[mipDensity(job->dst, universe->w, universe->h, x << level, ty << level, level)];
+            }
+            else if(universe->color != RANDOMCELL)
             {
-                drawSprite(highlightSprite, CurrentGrid[x][y].box.x - CELLSPACINGX, CurrentGrid[x][y].box.y - CELLSPACINGY, 0, SDL_FLIP_NONE);
+                row[tx] = shades[BOARDCELL(job->dst, x, ty) * 255];
+            }
+            else
+            {
+                row[tx] = BOARDCELL(job->dst, x, ty) ? paletteColors[universe->colors[x * MAXCELLSY + ty]] : deadColor;
             }
         }
     }
 }
 
-Cell* selectedCell()
+int checkFusedRender(Engine *engine)
 {
-    for(int x = 0; x < gridSizeX; x++)
+    // Universes of different sizes, the last two only partly visible
+    int sizes[FUSEDCHECKS][2] = { { MAXCELLSX, MAXCELLSY }, { MAXCELLSX - 13, MAXCELLSY - 9 }, { 130, 70 } };
+    int visible[FUSEDCHECKS][4] = { { 0, 0, MAXCELLSX, MAXCELLSY }, { 37, 101, 400, 333 }, { 0, 5, 130, 70 } };
+    Universe universes[FUSEDCHECKS];
+    StepJob jobs[FUSEDCHECKS];
+    Board *expect = createBoard(MAXCELLSX, MAXCELLSY);
+    int failed = expect == NULL;
+
+    memset(universes, 0, sizeof(universes));
+
+    for(int i = 0; i < FUSEDCHECKS; i++)
+    {
+        Universe *universe = &universes[i];
+
+        universe->current = createBoard(MAXCELLSX, MAXCELLSY);
+        universe->next = createBoard(MAXCELLSX, MAXCELLSY);
+        universe->colors = malloc(MAXCELLSX * MAXCELLSY);
+        universe->fusedPixels = malloc(sizeof(Uint32) * MAXCELLSX * MAXCELLSY);
+        universe->w = sizes[i][0];
+        universe->h = sizes[i][1];
+
+        if(universe->current == NULL || universe->next == NULL || universe->colors == NULL || universe->fusedPixels == NULL)
+        {
+            failed = 1;
+        }
+    }
+
+    for(int level = 0; level <= MIPLEVELS && !failed; level++)
     {
-        for(int y = 0; y < gridSizeY; y++)
+        int step = 1 << level;
+
+        // One color with dead edges, then multi color wrapped
+        for(int check = 0; check < 2 && !failed; check++)
         {
-            if(mouseCollide(&CurrentGrid[x][y].box))
+            int color = check ? RANDOMCELL : REDCELL;
+            int wrap = check;
+
+            for(int i = 0; i < FUSEDCHECKS; i++)
             {
-                return &CurrentGrid[x][y];
+                Universe *universe = &universes[i];
+                int *cells = visible[i];
+
+                randomizeBoard(universe->current, (Uint64)(level * 16 + check * 4 + i + 1));
+                copyBoard(universe->next, universe->current);
+                fillRandomColors(universe);
+
+                // Set up as fuseUniverse does for the visible region in texels
+                universe->color = color;
+                universe->fusedRect.x = cells[0] >> level;
+                universe->fusedRect.y = cells[1] >> level;
+                universe->fusedRect.w = ((cells[2] + step - 1) >> level) - universe->fusedRect.x;
+                universe->fusedRect.h = ((cells[3] + step - 1) >> level) - universe->fusedRect.y;
+                universe->fusedLevel = level;
+                universe->fusedColor = color;
+
+                for(int s = 0; s < 256; s++)
+                {
+                    universe->fusedShades[s] = blendColor(deadColor, paletteColors[color], s);
+                }
+
+                StepJob job = { engine, universe->current, universe->next, universe->w, universe->h, wrap, renderBand, universe };
+                jobs[i] = job;
+            }
+
+            stepBoards(engine, jobs, FUSEDCHECKS);
+
+            for(int i = 0; i < FUSEDCHECKS && !failed; i++)
+            {
+                Universe *universe = &universes[i];
+                SDL_Rect *region = &universe->fusedRect;
+
+                stepReference(universe->current, expect, universe->w, universe->h, wrap);
+
+                Board *swap = universe->current;
+                universe->current = universe->next;
+                universe->next = swap;
+
+                for(int y = 0; y < universe->h && !failed; y++)
+                {
+                    for(int x = 0; x < universe->w; x++)
+                    {
+                        if(BOARDCELL(universe->current, x, y) != BOARDCELL(expect, x, y))
+                        {
+                            printf("FAIL: %s engine, batch of %i universes, %ix%i universe, %s edges: cell (%i,%i) differs\n",
+                                   engine->name, FUSEDCHECKS, universe->w, universe->h, wrap ? "wrapped" : "dead", x, y);
+                            failed = 1;
+                            break;
+                        }
+                    }
+                }
+
+                // The pixels the window would have built from the new generation without fusing
+                if(level == 0)
+                {
+                    fillCellPixels(universe, region);
+                }
+                else
+                {
+                    buildMipLevels(universe, region, level);
+                    fillMipPixels(universe, region, level);
+                }
+
+                if(!failed && memcmp(lodPixels, universe->fusedPixels, sizeof(Uint32) * region->w * region->h) != 0)
+                {
+                    printf("FAIL: %s engine, fused pixels of a %ix%i universe, level %i, %s, %s edges differ from the unfused ones\n",
+                           engine->name, universe->w, universe->h, level, color == RANDOMCELL ? "multi color" : "one color",
+                           wrap ? "wrapped" : "dead");
+                    failed = 1;
+                }
             }
         }
     }
 
-    return NULL;
+    for(int i = 0; i < FUSEDCHECKS; i++)
+    {
+        freeBoard(universes[i].current);
+        freeBoard(universes[i].next);
+        free(universes[i].colors);
+        free(universes[i].fusedPixels);
+    }
+
+    freeBoard(expect);
+
+    return failed;
 }
 
-int countLiveNeighbors(int x, int y)
+int mipDensity(Board *board, int w, int h, int x, int y, int level)
 {
-    // The number of live neighbors
-    int value = 0;
+    // Averages the 2^level square of cells at (x,y) the same way buildMipLevels does
+    int sum = 0;
 
-    // This nested loop enumerates the 9 cells in the specified cells neighborhood
-    for(int j = -1; j <= 1; j++)
+    if(level == 1)
     {
-        // If gLoopEdges is set to 0 and y+j is off the board, continue
-        if((!gLoopEdges && y + j < 0) || y + j >= gridSizeY)
+        if(x >= w || y >= h)
         {
-            continue;
+            return 0;
+        }
+
+        // x is even, so both cells of a row are in the same word
+        Uint64 mask = x + 1 < w ? 3 : 1;
+        int count = __builtin_popcountll((BOARDWORD(board, x, y) >> (x & 63)) & mask);
+
+        if(y + 1 < h)
+        {
+            count += __builtin_popcountll((BOARDWORD(board, x, y + 1) >> (x & 63)) & mask);
+        }
+
+        return count * 255 / 4;
+    }
+
+    int half = 1 << (level - 1);
+
+    for(int i = 0; i < 4; i++)
+    {
+        sum += mipDensity(board, w, h, x + (i & 1) * half, y + (i >> 1) * half, level - 1);
+    }
+
+    return sum / 4;
+}
+
+void drawGrid()
+{
+    // Each universe is drawn into its own pane with the shared camera
+    for(int i = 0; i < universeCount; i++)
+    {
+        Universe *universe = &Universes[i];
+
+        SDL_RenderSetViewport(gRenderer, &universe->pane);
+        drawUniverse(universe);
+
+        if(universe == gUniverse && gSelection.w > 0)
+        {
+            drawSelection(&gSelection);
         }
 
-        // Loop around the edges if y+j is off the board
-        int k = (y + j + gridSizeY) % gridSizeY;
+        // Name the armed pattern next to the pointer, at every level of detail
+        if(universe == gUniverse && gStampPattern != NULL)
+        {
+            drawText(gStampPattern->name, gMouseX - universe->pane.x + LABELOFFSET, gMouseY - universe->pane.y + LABELOFFSET, 1);
+        }
 
-        for(int i = -1; i <= 1; i++)
+        // Outline the universe the buttons act on
+        if(universe == gUniverse && universeCount > 1)
         {
-            // If gLoopEdges is set to 0 and x+i is off the board, continue
-            if((!gLoopEdges && x + i < 0) || x + i >= gridSizeX)
+            SDL_Rect outline = { 0, 0, universe->pane.w, universe->pane.h };
+            SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0x80);
+            SDL_RenderDrawRect(gRenderer, &outline);
+            SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, SDL_ALPHA_OPAQUE);
+            gDrawCalls++;
+        }
+    }
+
+    SDL_RenderSetViewport(gRenderer, NULL);
+}
+
+int drawLevel()
+{
+    double pitch = cameraPitch();
+
+    // Pick the level of detail from the on-screen size of a cell, -1 for LED sprites
+    if(pitch >= LEDMINPITCH)
+    {
+        return -1;
+    }
+    else if(pitch >= 1.0)
+    {
+        return 0;
+    }
+
+    int level = (int)ceil(log2(1.0 / pitch));
+
+    return level < MIPLEVELS ? level : MIPLEVELS;
+}
+
+int levelRegion(SDL_Rect *region, int level)
+{
+    int x0, y0, x1, y1;
+    int step = 1 << level;
+
+    visibleCells(&x0, &y0, &x1, &y1);
+
+    if(x1 <= x0 || y1 <= y0)
+    {
+        return 0;
+    }
+
+    // Visible region in texels of the chosen level
+    region->x = x0 >> level;
+    region->y = y0 >> level;
+    region->w = ((x1 + step - 1) >> level) - region->x;
+    region->h = ((y1 + step - 1) >> level) - region->y;
+
+    return 1;
+}
+
+void drawUniverse(Universe *universe)
+{
+    int level = drawLevel();
+
+    if(level < 0)
+    {
+        drawGridSprites(universe);
+    }
+    else
+    {
+        drawGridPixels(universe, level);
+    }
+}
+
+void drawSelection(SDL_Rect *region)
+{
+    SDL_Rect box;
+    box.x = (int)floor(cellScreenX(region->x));
+    box.y = (int)floor(cellScreenY(region->y));
+    box.w = (int)floor(cellScreenX(region->x + region->w)) - box.x;
+    box.h = (int)floor(cellScreenY(region->y + region->h)) - box.y;
+
+    // Tint the selected cells and outline them, at every level of detail
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0x30);
+    SDL_RenderFillRect(gRenderer, &box);
+    SDL_SetRenderDrawColor(gRenderer, 0xFF, 0xFF, 0xFF, 0xC0);
+    SDL_RenderDrawRect(gRenderer, &box);
+    SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, SDL_ALPHA_OPAQUE);
+    gDrawCalls += 2;
+
+    // Label the outline with what N would fill it with, inside it when there is no room above
+    char label[16];
+    snprintf(label, sizeof(label), "FILL %i%%", gFillDensity);
+    drawText(label, box.x, box.y >= LABELOFFSET ? box.y - LABELOFFSET : box.y + 3, 1);
+}
+
+void drawGridSprites(Universe *universe)
+{
+    int x0, y0, x1, y1;
+    int hoverX = -1;
+    int hoverY = -1;
+
+    visibleCells(&x0, &y0, &x1, &y1);
+
+    if(universe == gUniverse && !universe->play)
+    {
+        selectedCell(&hoverX, &hoverY);
+    }
+
+    double zoom = gCamera.zoom;
+    int w = (int)lround(deadSprite->w * zoom);
+    int h = (int)lround(deadSprite->h * zoom);
+
+    // Use the hand-drawn sprites at their native size, and LEDs generated
+    // at exactly the on-screen size at every other zoom level
+    Sprite *sprites[LEDOFF + 1];
+    Sprite *highlight = highlightSprite;
+
+    for(int i = 0; i < LEDOFF; i++)
+    {
+        sprites[i] = w == deadSprite->w ? liveSprites[i] : ledSprite(i, w);
+    }
+
+    if(w == deadSprite->w)
+    {
+        sprites[LEDOFF] = deadSprite;
+    }
+    else
+    {
+        sprites[LEDOFF] = ledSprite(LEDOFF, w);
+        highlight = ledSprite(LEDHIGHLIGHT, (int)lround(highlightSprite->w * zoom));
+    }
+
+    for(int x = x0; x < x1; x++)
+    {
+        for(int y = y0; y < y1; y++)
+        {
+            SDL_Rect dest;
+            dest.x = (int)floor(cellScreenX(x) + CELLSPACINGX * zoom);
+            dest.y = (int)floor(cellScreenY(y) + CELLSPACINGY * zoom);
+            dest.w = w;
+            dest.h = h;
+
+            drawSpriteScaled(sprites[cellLed(universe, x, y)], &dest);
+        }
+    }
+
+    if(hoverX >= 0 && gStampPattern != NULL)
+    {
+        // Preview the armed pattern where a click would stamp it
+        Board *cells = patternCells(gStampPattern, gStampOrientation);
+        int px = hoverX - cells->w / 2;
+        int py = hoverY - cells->h / 2;
+
+        for(int y = 0; y < cells->h; y++)
+        {
+            for(int x = 0; x < cells->w; x++)
             {
-                continue;
+                if(BOARDCELL(cells, x, y) && px + x >= x0 && px + x < x1 && py + y >= y0 && py + y < y1)
+                {
+                    SDL_Rect dest;
+                    dest.x = (int)floor(cellScreenX(px + x));
+                    dest.y = (int)floor(cellScreenY(py + y));
+                    dest.w = (int)lround(highlightSprite->w * zoom);
+                    dest.h = (int)lround(highlightSprite->h * zoom);
+
+                    drawSpriteScaled(highlight, &dest);
+                }
             }
+        }
+    }
+    else if(hoverX >= 0)
+    {
+        SDL_Rect dest;
+        dest.x = (int)floor(cellScreenX(hoverX));
+        dest.y = (int)floor(cellScreenY(hoverY));
+        dest.w = (int)lround(highlightSprite->w * zoom);
+        dest.h = (int)lround(highlightSprite->h * zoom);
 
-            // Loop around the edges if x+i is off the board
-            int h = (x + i + gridSizeX) % gridSizeX;
+        drawSpriteScaled(highlight, &dest);
+    }
+}
 
-            // Count the neighbor cell at (h,k) if it is alive
-            value += CurrentGrid[h][k].alive ? 1 : 0;
+void drawGridPixels(Universe *universe, int level)
+{
+    int step = 1 << level;
+    SDL_Rect region;
+
+    if(!levelRegion(&region, level))
+    {
+        return;
+    }
+
+    if(universe->lodTexture == NULL)
+    {
+        universe->lodTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, MAXCELLSX, MAXCELLSY);
+        if(universe->lodTexture == NULL)
+        {
+            printf("Unable to create grid texture! SDL Error: %s\n", SDL_GetError());
+            gQuit = 1;
+            return;
+        }
+    }
+
+    // Only rebuild the texture when the grid or the visible region changed
+    if(universe->lodVersion != universe->version || universe->lodLevel != level || universe->lodColor != universe->color
+    || universe->lodRect.x != region.x || universe->lodRect.y != region.y || universe->lodRect.w != region.w
+    || universe->lodRect.h != region.h)
+    {
+        Uint32 *pixels = lodPixels;
+
+        // Pixels built while stepping this generation are uploaded as they are
+        if(universe->fusedVersion == universe->version && universe->fusedLevel == level
+        && universe->fusedColor == universe->color && SDL_RectEquals(&universe->fusedRect, &region))
+        {
+            pixels = universe->fusedPixels;
         }
+        else if(level == 0)
+        {
+            fillCellPixels(universe, &region);
+        }
+        else
+        {
+            buildMipLevels(universe, &region, level);
+            fillMipPixels(universe, &region, level);
+        }
+
+        SDL_Rect texRect = { 0, 0, region.w, region.h };
+        SDL_UpdateTexture(universe->lodTexture, &texRect, pixels, region.w * sizeof(Uint32));
+
+        universe->lodRect = region;
+        universe->lodLevel = level;
+        universe->lodVersion = universe->version;
+        universe->lodColor = universe->color;
     }
 
-    // Subtract 1 if (x,y) is alive since we counted it as a neighbor
-    return value - (CurrentGrid[x][y].alive ? 1 : 0);
+    SDL_Rect src = { 0, 0, region.w, region.h };
+    SDL_Rect dest;
+    dest.x = (int)floor(cellScreenX(region.x * step));
+    dest.y = (int)floor(cellScreenY(region.y * step));
+    dest.w = (int)ceil(region.w * step * cameraPitch());
+    dest.h = (int)ceil(region.h * step * cameraPitch());
+
+    SDL_RenderCopy(gRenderer, universe->lodTexture, &src, &dest);
+    gDrawCalls++;
 }
 
-void setGridColor(int color)
+void fillCellPixels(Universe *universe, SDL_Rect *region)
 {
-    gGridColor = color;
+    for(int y = 0; y < region->h; y++)
+    {
+        Uint32 *row = &lodPixels[y * region->w];
 
-    for(int x = 0; x < MAXCELLSX; x++)
+        for(int x = 0; x < region->w; x++)
+        {
+            row[x] = cellColor(universe, region->x + x, region->y + y);
+        }
+    }
+}
+
+void buildMipLevels(Universe *universe, SDL_Rect *region, int level)
+{
+    // Build each level from the one below it, limited to the texels under the region
+    for(int l = 1; l <= level; l++)
     {
-        for(int y = 0; y < MAXCELLSY; y++)
+        int shift = level - l;
+        int tx0 = region->x << shift;
+        int ty0 = region->y << shift;
+        int tx1 = (region->x + region->w) << shift;
+        int ty1 = (region->y + region->h) << shift;
+
+        for(int x = tx0; x < tx1; x++)
         {
-            switch(color)
+            for(int y = ty0; y < ty1; y++)
             {
-                case REDCELL: CurrentGrid[x][y].sprite[1] = redSprite;
-                    break;
-                case GREENCELL: CurrentGrid[x][y].sprite[1] = greenSprite;
-                    break;
-                case BLUECELL: CurrentGrid[x][y].sprite[1] = blueSprite;
-                    break;
-                case PURPLECELL: CurrentGrid[x][y].sprite[1] = purpleSprite;
-                    break;
-                case YELLOWCELL: CurrentGrid[x][y].sprite[1] = yellowSprite;
-                    break;
-                case RANDOMCELL:
-                    switch(rand() % 5)
+                int sum = 0;
+
+                for(int i = 0; i < 4; i++)
+                {
+                    int cx = (x << 1) + (i & 1);
+                    int cy = (y << 1) + (i >> 1);
+
+                    if(l == 1)
                     {
-                        case REDCELL: CurrentGrid[x][y].sprite[1] = redSprite;
-                            break;
-                        case GREENCELL: CurrentGrid[x][y].sprite[1] = greenSprite;
-                            break;
-                        case BLUECELL: CurrentGrid[x][y].sprite[1] = blueSprite;
-                            break;
-                        case PURPLECELL: CurrentGrid[x][y].sprite[1] = purpleSprite;
-                            break;
-                        case YELLOWCELL: CurrentGrid[x][y].sprite[1] = yellowSprite;
-                            break;
+                        if(cx < universe->w && cy < universe->h && BOARDCELL(universe->current, cx, cy))
+                        {
+                            sum += 255;
+                        }
+                    }
+                    else
+                    {
+                        sum += MipLevels[l - 2][cx][cy];
                     }
-                    break;
+                }
+
+                MipLevels[l - 1][x][y] = sum / 4;
             }
         }
     }
+}
+
+void fillMipPixels(Universe *universe, SDL_Rect *region, int level)
+{
+    Uint32 live = paletteColors[universe->color];
+
+    for(int y = 0; y < region->h; y++)
+    {
+        Uint32 *row = &lodPixels[y * region->w];
+
+        for(int x = 0; x < region->w; x++)
+        {
+            row[x] = blendColor(deadColor, live, MipLevels[level - 1][region->x + x][region->y + y]);
+        }
+    }
+}
+
+int cellLed(Universe *universe, int x, int y)
+{
+    if(!BOARDCELL(universe->current, x, y))
+    {
+        return LEDOFF;
+    }
+
+    return universe->color == RANDOMCELL ? universe->colors[x * MAXCELLSY + y] : universe->color;
+}
+
+Uint32 cellColor(Universe *universe, int x, int y)
+{
+    int led = cellLed(universe, x, y);
+
+    return led == LEDOFF ? deadColor : paletteColors[led];
+}
+
+Uint32 blendColor(Uint32 a, Uint32 b, int t)
+{
+    Uint32 color = 0xFF000000;
+
+    for(int shift = 0; shift < 24; shift += 8)
+    {
+        int ca = (a >> shift) & 0xFF;
+        int cb = (b >> shift) & 0xFF;
+        color |= (Uint32)(ca + ((cb - ca) * t) / 255) << shift;
+    }
+
+    return color;
+}
+
+int selectedCell(int *x, int *y)
+{
+    // The camera maps the mouse straight to a cell of the pane, no need to search the grid
+    return screenToCell(gMouseX - gUniverse->pane.x, gMouseY - gUniverse->pane.y, x, y);
+}
+
+int getCell(Universe *universe, int x, int y)
+{
+    return BOARDCELL(universe->current, x, y);
+}
+
+void setCell(Universe *universe, int x, int y, int alive)
+{
+    if(!gClientMode && x >= 0 && y >= 0 && x < universe->w && y < universe->h && setBoardCell(universe->current, x, y, alive))
+    {
+        universe->version++;
+    }
+}
+
+void stampCells(Universe *universe, Pattern *pattern, int orientation, int x, int y)
+{
+    if(gClientMode)
+    {
+        return;
+    }
+
+    // Cells past the edge of the grid are clipped rather than wrapped
+    journalUniverse(universe);
+    stampPattern(universe->current, universe->w, universe->h, pattern, orientation, x, y);
+    journalUniverse(universe);
+    universe->version++;
+}
+
+int clipRegion(Universe *universe, SDL_Rect *region)
+{
+    // Trim the region to the grid, returns 0 if nothing is left
+    if(region->x < 0)
+    {
+        region->w += region->x;
+        region->x = 0;
+    }
+
+    if(region->y < 0)
+    {
+        region->h += region->y;
+        region->y = 0;
+    }
+
+    if(region->x + region->w > universe->w)
+    {
+        region->w = universe->w - region->x;
+    }
+
+    if(region->y + region->h > universe->h)
+    {
+        region->h = universe->h - region->y;
+    }
+
+    if(region->w <= 0 || region->h <= 0)
+    {
+        region->w = 0;
+        region->h = 0;
+        return 0;
+    }
+
+    return 1;
+}
+
+void fillRegion(Universe *universe, SDL_Rect *region, int density)
+{
+    if(gClientMode || !clipRegion(universe, region))
+    {
+        return;
+    }
+
+    // Same as clearCells (density 0) or the random button, but only inside the region
+    journalUniverse(universe);
+    fillBoardRegion(universe->current, region->x, region->y, region->w, region->h, density, ((Uint64)rand() << 32) ^ (Uint64)rand());
+    journalUniverse(universe);
+    universe->version++;
+}
+
+Board* copyRegion(Universe *universe, SDL_Rect *region)
+{
+    if(!clipRegion(universe, region))
+    {
+        return NULL;
+    }
+
+    Board *cells = createBoard(region->w, region->h);
+    if(cells != NULL)
+    {
+        blitBoard(cells, 0, 0, region->w, region->h, universe->current, region->x, region->y, region->w, region->h, BLITCOPY);
+    }
+
+    return cells;
+}
+
+void transformRegion(Universe *universe, SDL_Rect *region, int orientation)
+{
+    if(gClientMode)
+    {
+        return;
+    }
+
+    Board *cells = copyRegion(universe, region);
+    if(cells == NULL)
+    {
+        return;
+    }
+
+    Board *moved = transformBoard(cells, cells->w, cells->h, orientation);
+    if(moved != NULL)
+    {
+        // The region keeps its top left corner and takes the new shape
+        journalUniverse(universe);
+        fillBoardRegion(universe->current, region->x, region->y, region->w, region->h, 0, 0);
+        blitBoard(universe->current, region->x, region->y, universe->w, universe->h, moved, 0, 0, moved->w, moved->h, BLITCOPY);
+        journalUniverse(universe);
+        region->w = moved->w;
+        region->h = moved->h;
+        clipRegion(universe, region);
+        universe->version++;
+    }
+
+    freeBoard(moved);
+    freeBoard(cells);
+}
+
+void paintLine(Universe *universe, int x0, int y0, int x1, int y1, int alive)
+{
+    // Bresenham's line algorithm so fast strokes leave no gaps between cells
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+
+    while(1)
+    {
+        setCell(universe, x0, y0, alive);
+
+        if(x0 == x1 && y0 == y1)
+        {
+            break;
+        }
+
+        int e2 = 2 * err;
+
+        if(e2 >= dy)
+        {
+            err += dy;
+            x0 += sx;
+        }
+
+        if(e2 <= dx)
+        {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+int countPopulation()
+{
+    return (int)countBoardCells(gUniverse->current, gUniverse->w, gUniverse->h);
+}
+
+int countLiveNeighbors(int x, int y)
+{
+    return countBoardNeighbors(gUniverse->current, x, y, gUniverse->w, gUniverse->h, gUniverse->wrap);
+}
+
+void setGridColor(Universe *universe, int color)
+{
+    universe->color = color;
+
+    // Solid colors are a single palette entry, only multi needs per-cell colors
+    if(color == RANDOMCELL)
+    {
+        fillRandomColors(universe);
+    }
 
-    memcpy(NextGrid, CurrentGrid, sizeof(CurrentGrid));
+    universe->version++;
 }
 
+void fillRandomColors(Universe *universe)
+{
+    Uint8 *colors = universe->colors;
+    size_t size = MAXCELLSX * MAXCELLSY;
+    Uint64 state = ((Uint64)rand() << 32) ^ (Uint64)rand() ^ 0x9E3779B97F4A7C15ull;
+
+    // Each xorshift64 step yields 8 random bytes, scaled into the 5 solid colors
+    for(size_t i = 0; i < size; i += 8)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        Uint64 bits = state;
+        for(size_t j = i; j < i + 8 && j < size; j++)
+        {
+            colors[j] = (Uint8)(((bits & 0xFF) * RANDOMCELL) >> 8);
+            bits >>= 8;
+        }
+    }
+}
@@ -18,6 +18,11 @@
 #define GRID_H
 
 #include "graphics.h"
+#include "patterns.h"
+#include "journal.h"
+#include "export.h"
+
+#define MAXUNIVERSES 4 // Universes shown side by side in one window
 
 enum CELLCOLORS
 {
@@ -44,23 +49,95 @@ enum GRIDSPEED
     SPD5 = 25
 };
 
-typedef struct CELL_S
+typedef struct UNIVERSE_S
 {
-    Sprite *sprite[2];
-    SDL_Rect box;
-    int alive;
-} Cell;
+    // Packed cells, swapped after every step. Outside the w x h region
+    // both boards always hold the same cells
+    Board *current;
+    Board *next;
+    Uint8 *colors; // Palette index of each cell, only used when color is RANDOMCELL
+    Journal journal; // Undo history of the current board
+    int w; // Size of the grid in cells, the same for every universe
+    int h;
+    int wrap; // Wrap the grid around into a torus
+    int color;
+    int stroke; // State the paint stroke being applied sets cells to, see PAINTTOGGLE
+    int play;
+    int speed;
+    int density; // Percentage of live cells left by the random button
+    Uint32 due; // Ticks at which a playing universe takes its next step
+    int version; // Bumped whenever the contents of the grid change
+    Uint64 generation; // Generations stepped since startup
+    SDL_Rect pane; // Part of the window the universe is drawn in
+
+    // Streaming texture that holds the visible part of the grid at pixel and mipmap zoom levels
+    SDL_Texture *lodTexture;
+    SDL_Rect lodRect; // Visible region (in texels) currently uploaded to lodTexture
+    int lodLevel; // Mip level currently uploaded to lodTexture
+    int lodVersion; // Grid version currently uploaded to lodTexture
+    int lodColor; // Grid color currently uploaded to lodTexture
+
+    // Pixels of the visible region built while stepping, when the step and render passes are fused
+    Uint32 *fusedPixels;
+    SDL_Rect fusedRect; // Visible region (in texels) held in fusedPixels
+    int fusedLevel; // Mip level of fusedPixels
+    int fusedVersion; // Grid version held in fusedPixels
+    int fusedColor; // Grid color used for fusedPixels
+    Uint32 fusedShades[256]; // Pixel of each density from dead to live, for fusedColor
+} Universe;
+
+extern Universe Universes[];
+extern int universeCount;
+extern Universe *gUniverse;
 
+void initUniverses(int count, int *densities);
 void initGrid();
 int loadGridSprites();
 void resizeGrid();
 void clearGrid();
-void clearCells();
-void updateGrid();
+void clearCells(Universe *universe);
+void randomizeUniverse(Universe *universe);
+void journalUniverse(Universe *universe);
+int undoEdit(Universe *universe);
+int redoEdit(Universe *universe);
+void focusUniverse(Universe *universe);
+Universe* universeAt(int x, int y);
+int universesPlaying();
+int gridVersion();
+void updateGrid(Universe *universe);
+void stepUniverses();
+void swapUniverse(Universe *universe);
+int exportUniverses(char *name, int slots);
+int fuseUniverse(Universe *universe, StepJob *job);
+void renderBand(StepJob *job, int y0, int y1);
+int checkFusedRender(Engine *engine);
+int mipDensity(Board *board, int w, int h, int x, int y, int level);
 void drawGrid();
-Cell* selectedCell();
+int drawLevel();
+int levelRegion(SDL_Rect *region, int level);
+void drawUniverse(Universe *universe);
+void drawSelection(SDL_Rect *region);
+void drawGridSprites(Universe *universe);
+void drawGridPixels(Universe *universe, int level);
+void fillCellPixels(Universe *universe, SDL_Rect *region);
+void buildMipLevels(Universe *universe, SDL_Rect *region, int level);
+void fillMipPixels(Universe *universe, SDL_Rect *region, int level);
+int cellLed(Universe *universe, int x, int y);
+Uint32 cellColor(Universe *universe, int x, int y);
+Uint32 blendColor(Uint32 a, Uint32 b, int t);
+int selectedCell(int *x, int *y);
+int getCell(Universe *universe, int x, int y);
+void setCell(Universe *universe, int x, int y, int alive);
+void stampCells(Universe *universe, Pattern *pattern, int orientation, int x, int y);
+int clipRegion(Universe *universe, SDL_Rect *region);
+void fillRegion(Universe *universe, SDL_Rect *region, int density);
+Board* copyRegion(Universe *universe, SDL_Rect *region);
+void transformRegion(Universe *universe, SDL_Rect *region, int orientation);
+void paintLine(Universe *universe, int x0, int y0, int x1, int y1, int alive);
+int countPopulation();
 int countLiveNeighbors(int x, int y);
-void setGridColor(int color);
+void setGridColor(Universe *universe, int color);
+void fillRandomColors(Universe *universe);
 
 #endif
 
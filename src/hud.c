@@ -0,0 +1,296 @@
+// ###########################################################################
+//          Title: YaGoL HUD Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Collects performance counters and draws them as a
+//                 toggleable overlay using a built-in bitmap font.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "hud.h"
+#include "grid.h"
+
+#define FONTFIRST 32 // First character in the font (space)
+#define FONTLAST 90 // Last character in the font (Z)
+#define FONTW 5
+#define FONTH 7
+#define FONTCELLW 6 // Glyph width plus one pixel of spacing
+#define HUDLINEH 10
+#define HUDPADDING 4
+
+extern SDL_Renderer *gRenderer;
+extern int gDrawCalls;
+extern int gActiveThreads;
+
+// 5x7 glyphs, one byte per row with the leftmost pixel in bit 4
+Uint8 hudFont[FONTLAST - FONTFIRST + 1][FONTH] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // !
+    { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 }, // "
+    { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A }, // #
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, // $
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, // &
+    { 0x0C, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // '
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, // *
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // +
+    { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ,
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // .
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // ;
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // <
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // =
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // >
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // ?
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, // @
+    { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // A
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+    { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 }, // Y
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+};
+
+SDL_Texture *fontTexture = NULL;
+
+int gShowHud = 0; // HUD is hidden by default
+
+HudSample hudSamples[HUDSAMPLES];
+int hudSampleCount = 0;
+int hudSampleNext = 0;
+HudSample hudFrame; // Counters for the frame in progress
+
+int initHud()
+{
+    Uint32 pixels[(FONTLAST - FONTFIRST + 1) * FONTCELLW * FONTH];
+    int pitch = (FONTLAST - FONTFIRST + 1) * FONTCELLW;
+
+    // Expand the font into a white-on-transparent texture, one glyph after another
+    for(int c = 0; c <= FONTLAST - FONTFIRST; c++)
+    {
+        for(int y = 0; y < FONTH; y++)
+        {
+            for(int x = 0; x < FONTCELLW; x++)
+            {
+                int set = x < FONTW && (hudFont[c][y] & (0x10 >> x));
+                pixels[y * pitch + c * FONTCELLW + x] = set ? 0xFFFFFFFF : 0x00000000;
+            }
+        }
+    }
+
+    fontTexture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, pitch, FONTH);
+    if(fontTexture == NULL)
+    {
+        printf("Unable to create HUD font texture! SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    SDL_UpdateTexture(fontTexture, NULL, pixels, pitch * sizeof(Uint32));
+    SDL_SetTextureBlendMode(fontTexture, SDL_BLENDMODE_BLEND);
+
+    memset(&hudFrame, 0, sizeof(hudFrame));
+
+    return 1;
+}
+
+void toggleHud()
+{
+    gShowHud = !gShowHud;
+}
+
+Uint64 hudTimer()
+{
+    return SDL_GetPerformanceCounter();
+}
+
+void hudAddSim(Uint64 start)
+{
+    hudFrame.simTicks += SDL_GetPerformanceCounter() - start;
+}
+
+void hudAddRender(Uint64 start)
+{
+    hudFrame.renderTicks += SDL_GetPerformanceCounter() - start;
+}
+
+void hudAddGeneration()
+{
+    hudFrame.generations++;
+}
+
+void endHudFrame()
+{
+    hudFrame.time = SDL_GetPerformanceCounter();
+    hudFrame.drawCalls = gDrawCalls;
+    gDrawCalls = 0;
+
+    hudSamples[hudSampleNext] = hudFrame;
+    hudSampleNext = (hudSampleNext + 1) % HUDSAMPLES;
+    if(hudSampleCount < HUDSAMPLES)
+    {
+        hudSampleCount++;
+    }
+
+    memset(&hudFrame, 0, sizeof(hudFrame));
+}
+
+void drawHud(int x, int y)
+{
+    static int population = 0;
+    static int populationVersion = -1;
+    static Universe *populationUniverse = NULL;
+
+    if(!gShowHud || fontTexture == NULL)
+    {
+        return;
+    }
+
+    // Average the samples that fall inside the sliding window
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 oldest = now;
+    Uint64 simTicks = 0;
+    Uint64 renderTicks = 0;
+    int generations = 0;
+    int drawCalls = 0;
+    int frames = 0;
+
+    for(int i = 1; i <= hudSampleCount; i++)
+    {
+        HudSample *sample = &hudSamples[(hudSampleNext - i + HUDSAMPLES) % HUDSAMPLES];
+
+        if((now - sample->time) * 1000 / freq > HUDWINDOW)
+        {
+            break;
+        }
+
+        oldest = sample->time;
+        simTicks += sample->simTicks;
+        renderTicks += sample->renderTicks;
+        generations += sample->generations;
+        drawCalls += sample->drawCalls;
+        frames++;
+    }
+
+    double seconds = frames > 1 ? (double)(now - oldest) / freq : 0;
+    double gensPerSecond = seconds > 0 ? generations / seconds : 0;
+    double simMs = generations > 0 ? (double)simTicks * 1000.0 / freq / generations : 0;
+    double renderMs = frames > 0 ? (double)renderTicks * 1000.0 / freq / frames : 0;
+    int drawsPerFrame = frames > 0 ? drawCalls / frames : 0;
+
+    // Population of the universe the buttons act on only needs recounting when it changed
+    if(populationVersion != gUniverse->version || populationUniverse != gUniverse)
+    {
+        population = countPopulation();
+        populationVersion = gUniverse->version;
+        populationUniverse = gUniverse;
+    }
+
+    char lines[3][48];
+    snprintf(lines[0], sizeof(lines[0]), "GEN/S %6.1f  SIM MS %6.2f", gensPerSecond, simMs);
+    snprintf(lines[1], sizeof(lines[1]), "DRAWS %6i  RND MS %6.2f", drawsPerFrame, renderMs);
+    snprintf(lines[2], sizeof(lines[2]), "POP %8i  THREADS %4i", population, gActiveThreads);
+
+    SDL_Rect panel;
+    panel.x = x;
+    panel.y = y;
+    panel.w = (int)strlen(lines[0]) * FONTCELLW + HUDPADDING * 2;
+    panel.h = 3 * HUDLINEH + HUDPADDING;
+
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, 0xA0);
+    SDL_RenderFillRect(gRenderer, &panel);
+    SDL_SetRenderDrawColor(gRenderer, 0x00, 0x00, 0x00, SDL_ALPHA_OPAQUE);
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_NONE);
+
+    for(int i = 0; i < 3; i++)
+    {
+        drawText(lines[i], x + HUDPADDING, y + HUDPADDING + i * HUDLINEH, 1);
+    }
+}
+
+void drawText(char *text, int x, int y, int scale)
+{
+    SDL_Rect src;
+    SDL_Rect dest;
+
+    src.y = 0;
+    src.w = FONTW;
+    src.h = FONTH;
+    dest.y = y;
+    dest.w = FONTW * scale;
+    dest.h = FONTH * scale;
+
+    for(int i = 0; text[i] != '\0'; i++)
+    {
+        int c = text[i];
+
+        if(c >= 'a' && c <= 'z')
+        {
+            c -= 'a' - 'A';
+        }
+
+        if(c < FONTFIRST || c > FONTLAST)
+        {
+            c = '?';
+        }
+
+        if(c != ' ')
+        {
+            src.x = (c - FONTFIRST) * FONTCELLW;
+            dest.x = x + i * FONTCELLW * scale;
+            SDL_RenderCopy(gRenderer, fontTexture, &src, &dest);
+        }
+    }
+}
+
+void closeHud()
+{
+    if(fontTexture != NULL)
+    {
+        SDL_DestroyTexture(fontTexture);
+        fontTexture = NULL;
+    }
+}
@@ -0,0 +1,45 @@
+// ###########################################################################
+//          Title: YaGoL HUD Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Collects performance counters and draws them as a
+//                 toggleable overlay using a built-in bitmap font.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef HUD_H
+#define HUD_H
+
+#include "graphics.h"
+
+#define HUDSAMPLES 256 // Frames kept in the sliding window ring buffer
+#define HUDWINDOW 1000 // Length of the sliding window in milliseconds
+
+typedef struct HUDSAMPLE_S
+{
+    Uint64 time; // Performance counter value at the end of the frame
+    Uint64 simTicks; // Time spent stepping the grid
+    Uint64 renderTicks; // Time spent drawing
+    int generations; // Generations stepped during the frame
+    int drawCalls; // Copies issued to the renderer during the frame
+} HudSample;
+
+int initHud();
+void toggleHud();
+Uint64 hudTimer();
+void hudAddSim(Uint64 start);
+void hudAddRender(Uint64 start);
+void hudAddGeneration();
+void endHudFrame();
+void drawHud(int x, int y);
+void drawText(char *text, int x, int y, int scale);
+void closeHud();
+
+#endif
@@ -13,25 +13,43 @@
 //    any later version.
 // ###########################################################################
 
+#include <math.h>
 #include "input.h"
 #include "grid.h"
+#include "camera.h"
+#include "hud.h"
+#include "trace.h"
+#include "patterns.h"
+#include "commands.h"
 
 #define BUTTONSPACINGX 16
 #define BUTTONXSTART 0
 #define BUTTONYOFFSET 35
+#define ZOOMSTEP 1.25 // Zoom factor per mouse wheel notch or key press
+#define PANSTEP 8 // Arrow keys pan by 1/PANSTEP of the view
+#define DENSITYSTEP 10 // Percentage points [ and ] change the fill density by
 
 extern int gQuit;
-extern int gGridColor;
-extern int gPlay;
-extern int gSpeed;
 extern int gCellSize;
 extern int gWinWidth;
 extern int gWinHeight;
+extern Camera gCamera;
 
 SDL_Event e;
 
 int gMouseX = 0;
 int gMouseY = 0;
+int gPanning = 0; // Set while the view is being dragged with the right or middle mouse button
+int gPainting = 0; // Set while cells are being painted by dragging with the left mouse button
+int gPaintX = -1; // Last cell painted by the current stroke
+int gPaintY = -1;
+Pattern *gStampPattern = NULL; // Pattern stamped by a left click, cells are painted when NULL
+int gStampOrientation = 0;
+SDL_Rect gSelection = { 0, 0, 0, 0 }; // Selected cells, nothing is selected while w is 0
+int gSelecting = 0; // Set while a selection is being dragged out with Shift and the left mouse button
+int gSelectX = 0; // Cell the selection was started from
+int gSelectY = 0;
+int gFillDensity = 50; // Percentage of live cells left by a random fill of the selection
 
 Sprite *highlightButtonSprite = NULL;
 Sprite *playButtonSprite = NULL;
@@ -74,15 +92,9 @@ void initInput()
         return;
     }
 
-    // Configure play button
-    if(gPlay)
-    {
-        playButton.sprite = stopButtonSprite;
-    }
-    else
-    {
-        playButton.sprite = playButtonSprite;
-    }
+    // Configure play, color and speed buttons for the universe the buttons act on
+    updateButtonSprites();
+
     playButton.box.w = playButton.sprite->w;
     playButton.box.h = playButton.sprite->h;
     playButton.clicked = 0;
@@ -105,40 +117,10 @@ void initInput()
     randomButton.box.h = randomButton.sprite->h;
     randomButton.clicked = 0;
 
-    // Configure color button
-    switch(gGridColor)
-    {
-        case REDCELL: colorButton.sprite = redButtonSprite;
-            break;
-        case GREENCELL: colorButton.sprite = greenButtonSprite;
-            break;
-        case BLUECELL: colorButton.sprite = blueButtonSprite;
-            break;
-        case PURPLECELL: colorButton.sprite = purpleButtonSprite;
-            break;
-        case YELLOWCELL: colorButton.sprite = yellowButtonSprite;
-            break;
-        case RANDOMCELL: colorButton.sprite = multiButtonSprite;
-            break;
-    }
     colorButton.box.w = colorButton.sprite->w;
     colorButton.box.h = colorButton.sprite->h;
     colorButton.clicked = 0;
 
-    // Configure speed button
-    switch(gSpeed)
-    {
-        case SPD1: speedButton.sprite = speed1ButtonSprite;
-            break;
-        case SPD2: speedButton.sprite = speed2ButtonSprite;
-            break;
-        case SPD3: speedButton.sprite = speed3ButtonSprite;
-            break;
-        case SPD4: speedButton.sprite = speed4ButtonSprite;
-            break;
-        case SPD5: speedButton.sprite = speed5ButtonSprite;
-            break;
-    }
     speedButton.box.w = speedButton.sprite->w;
     speedButton.box.h = speedButton.sprite->h;
     speedButton.clicked = 0;
@@ -165,6 +147,41 @@ void initInput()
     positionButtons(BUTTONXSTART, gWinHeight - BUTTONYOFFSET);
 }
 
+void updateButtonSprites()
+{
+    playButton.sprite = gUniverse->play ? stopButtonSprite : playButtonSprite;
+
+    switch(gUniverse->color)
+    {
+        case REDCELL: colorButton.sprite = redButtonSprite;
+            break;
+        case GREENCELL: colorButton.sprite = greenButtonSprite;
+            break;
+        case BLUECELL: colorButton.sprite = blueButtonSprite;
+            break;
+        case PURPLECELL: colorButton.sprite = purpleButtonSprite;
+            break;
+        case YELLOWCELL: colorButton.sprite = yellowButtonSprite;
+            break;
+        case RANDOMCELL: colorButton.sprite = multiButtonSprite;
+            break;
+    }
+
+    switch(gUniverse->speed)
+    {
+        case SPD1: speedButton.sprite = speed1ButtonSprite;
+            break;
+        case SPD2: speedButton.sprite = speed2ButtonSprite;
+            break;
+        case SPD3: speedButton.sprite = speed3ButtonSprite;
+            break;
+        case SPD4: speedButton.sprite = speed4ButtonSprite;
+            break;
+        case SPD5: speedButton.sprite = speed5ButtonSprite;
+            break;
+    }
+}
+
 int loadButtonSprites()
 {
     // Load button sprites
@@ -233,60 +250,120 @@ void positionButtons(int x, int y)
 
 void updateInput()
 {
+    int panX = 0;
+    int panY = 0;
+
+    // Drain the queue first. Clicks, releases, wheel and keys are handled in
+    // order, while mouse motion is merged into one final position per frame.
     while(SDL_PollEvent(&e) != 0)
     {
-        if(e.type == SDL_QUIT)
-        {
-            gQuit = 1;
-        }
+        // Any event may change what is on screen
+        requestRedraw();
 
-        if(e.type == SDL_MOUSEMOTION)
+        switch(e.type)
         {
-            gMouseX = e.motion.x;
-            gMouseY = e.motion.y;
+            case SDL_QUIT: gQuit = 1;
+                break;
+            case SDL_MOUSEMOTION: gMouseX = e.motion.x;
+                gMouseY = e.motion.y;
+
+                if(gPanning)
+                {
+                    panX += e.motion.xrel;
+                    panY += e.motion.yrel;
+                }
+
+                // Paint strokes are handled segment by segment so no cells are skipped
+                if((gPainting || gSelecting) && !gUniverse->play)
+                {
+                    updateGridInput(&e);
+                }
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP: gMouseX = e.button.x;
+                gMouseY = e.button.y;
+
+                // Clicking a pane makes its universe the one the buttons act on
+                if(e.type == SDL_MOUSEBUTTONDOWN && universeAt(gMouseX, gMouseY) != NULL)
+                {
+                    focusUniverse(universeAt(gMouseX, gMouseY));
+                    updateButtonSprites();
+                }
+
+                updateButtons(&e);
+                updateCameraInput(&e);
+
+                if(!gUniverse->play)
+                {
+                    updateGridInput(&e);
+                }
+                break;
+            case SDL_MOUSEWHEEL: updateCameraInput(&e);
+                break;
+            case SDL_KEYDOWN: updateKeyInput(&e);
+                updateCameraInput(&e);
+                break;
+            // render target contents are lost when the device is reset
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET: invalidateBackground();
+                break;
         }
+    }
 
-        // check if window was resized
-        if(checkWindowSize())
-        {
-            // resize grid to fill new window size
-            resizeGrid();
-
-            // and also reposition buttons
-            positionButtons(BUTTONXSTART, gWinHeight - BUTTONYOFFSET);
-        }
+    if(panX != 0 || panY != 0)
+    {
+        panCamera(panX, panY);
+        clampCamera();
+    }
 
-        updateButtons();
+    // check if window was resized
+    if(checkWindowSize())
+    {
+        // resize grid to fill new window size
+        resizeGrid();
 
-        if(!gPlay)
-        {
-            updateGridInput();
-        }
+        // and also reposition buttons
+        positionButtons(BUTTONXSTART, gWinHeight - BUTTONYOFFSET);
     }
+
+    // Update the button highlight once for the final mouse position
+    updateButtons(NULL);
+}
+
+int waitInput(int timeout)
+{
+    // Block until an event is queued, without removing it from the queue
+    return SDL_WaitEventTimeout(NULL, timeout);
+}
+
+int leftButton(SDL_Event *event, Uint32 type)
+{
+    return event != NULL && event->type == type && event->button.button == SDL_BUTTON_LEFT;
 }
 
-void updateButtons()
+void updateButtons(SDL_Event *event)
 {
     // Play Button
     if(mouseCollide(&playButton.box))
     {
         highlightButton = &playButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             playButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && playButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && playButton.clicked)
         {
-            if(gPlay)
+            if(gUniverse->play)
             {
-                gPlay = 0;
+                gUniverse->play = 0;
                 playButton.sprite = playButtonSprite;
             }
             else
             {
-                gPlay = 1;
+                gUniverse->play = 1;
+                gUniverse->due = SDL_GetTicks();
                 playButton.sprite = stopButtonSprite;
             }
 
@@ -298,21 +375,21 @@ void updateButtons()
     {
         highlightButton = &stepButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             stepButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && stepButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && stepButton.clicked)
         {
-            if(gPlay)
+            if(gUniverse->play)
             {
-                gPlay = 0;
+                gUniverse->play = 0;
                 playButton.sprite = playButtonSprite;
             }
             else
             {
-                updateGrid();
+                queueCommand(gUniverse, CMDSTEP, 0);
             }
 
             stepButton.clicked = 0;
@@ -323,20 +400,20 @@ void updateButtons()
     {
         highlightButton = &clearButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             clearButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && clearButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && clearButton.clicked)
         {
-            if(gPlay)
+            if(gUniverse->play)
             {
-                gPlay = 0;
+                gUniverse->play = 0;
                 playButton.sprite = playButtonSprite;
             }
 
-            clearCells();
+            queueCommand(gUniverse, CMDCLEAR, 0);
             clearButton.clicked = 0;
         }
     }
@@ -345,20 +422,20 @@ void updateButtons()
     {
         highlightButton = &randomButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             randomButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && randomButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && randomButton.clicked)
         {
-            if(gPlay)
+            if(gUniverse->play)
             {
-                gPlay = 0;
+                gUniverse->play = 0;
                 playButton.sprite = playButtonSprite;
             }
 
-            initGrid();
+            queueCommand(gUniverse, CMDRANDOM, 0);
             randomButton.clicked = 0;
         }
     }
@@ -367,34 +444,15 @@ void updateButtons()
     {
         highlightButton = &colorButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             colorButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && colorButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && colorButton.clicked)
         {
-            switch(gGridColor)
-            {
-                case REDCELL: setGridColor(GREENCELL);
-                    colorButton.sprite = greenButtonSprite;
-                    break;
-                case GREENCELL: setGridColor(BLUECELL);
-                    colorButton.sprite = blueButtonSprite;
-                    break;
-                case BLUECELL: setGridColor(PURPLECELL);
-                    colorButton.sprite = purpleButtonSprite;
-                    break;
-                case PURPLECELL: setGridColor(YELLOWCELL);
-                    colorButton.sprite = yellowButtonSprite;
-                    break;
-                case YELLOWCELL: setGridColor(RANDOMCELL);
-                    colorButton.sprite = multiButtonSprite;
-                    break;
-                case RANDOMCELL: setGridColor(REDCELL);
-                    colorButton.sprite = redButtonSprite;
-                    break;
-            }
+            // The color is picked when the command is applied, the sprite follows once it is
+            queueCommand(gUniverse, CMDCOLOR, COLORNEXT);
 
             colorButton.clicked = 0;
         }
@@ -404,28 +462,28 @@ void updateButtons()
     {
         highlightButton = &speedButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             speedButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && speedButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && speedButton.clicked)
         {
-            switch(gSpeed)
+            switch(gUniverse->speed)
             {
-                case SPD1: gSpeed = SPD2;
+                case SPD1: gUniverse->speed = SPD2;
                     speedButton.sprite = speed2ButtonSprite;
                     break;
-                case SPD2: gSpeed = SPD3;
+                case SPD2: gUniverse->speed = SPD3;
                     speedButton.sprite = speed3ButtonSprite;
                     break;
-                case SPD3: gSpeed = SPD4;
+                case SPD3: gUniverse->speed = SPD4;
                     speedButton.sprite = speed4ButtonSprite;
                     break;
-                case SPD4: gSpeed = SPD5;
+                case SPD4: gUniverse->speed = SPD5;
                     speedButton.sprite = speed5ButtonSprite;
                     break;
-                case SPD5: gSpeed = SPD1;
+                case SPD5: gUniverse->speed = SPD1;
                     speedButton.sprite = speed1ButtonSprite;
                     break;
             }
@@ -438,26 +496,26 @@ void updateButtons()
     {
         highlightButton = &sizeButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             sizeButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && sizeButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && sizeButton.clicked)
         {
             switch(gCellSize)
             {
                 case SMALL: gCellSize = LARGE;
-                    gPlay = 0;
+                    stopUniverses();
                     playButton.sprite = playButtonSprite;
                     sizeButton.sprite = sizeLgButtonSprite;
-                    initGrid();
+                    restartUniverses();
                     break;
                 case LARGE: gCellSize = SMALL;
-                    gPlay = 0;
+                    stopUniverses();
                     playButton.sprite = playButtonSprite;
                     sizeButton.sprite = sizeSmButtonSprite;
-                    initGrid();
+                    restartUniverses();
                     break;
             }
 
@@ -469,12 +527,12 @@ void updateButtons()
     {
         highlightButton = &quitButton;
 
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
+        if(leftButton(event, SDL_MOUSEBUTTONDOWN))
         {
             quitButton.clicked = 1;
         }
 
-        if(e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT && quitButton.clicked)
+        if(leftButton(event, SDL_MOUSEBUTTONUP) && quitButton.clicked)
         {
             gQuit = 1;
             quitButton.clicked = 0;
@@ -486,26 +544,297 @@ void updateButtons()
     }
 }
 
-void updateGridInput()
+void stopUniverses()
 {
-    Cell *cell = selectedCell();
+    // Resizing cells starts every universe over
+    for(int i = 0; i < universeCount; i++)
+    {
+        Universes[i].play = 0;
+    }
+}
 
-    if(cell != NULL)
+void restartUniverses()
+{
+    // New cell sprites and layout, then every universe starts over from random cells
+    if(loadGridSprites())
     {
-        if(e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT)
-        {
-            if(cell->alive)
+        gQuit = 1;
+        return;
+    }
+
+    resizeGrid();
+
+    for(int i = 0; i < universeCount; i++)
+    {
+        queueCommand(&Universes[i], CMDRANDOM, 0);
+    }
+}
+
+void updateKeyInput(SDL_Event *event)
+{
+    int ctrl = event->key.keysym.mod & KMOD_CTRL;
+
+    switch(event->key.keysym.sym)
+    {
+        case SDLK_F3: toggleHud();
+            break;
+        case SDLK_F12: writeTrace();
+            break;
+        case SDLK_TAB: focusUniverse(&Universes[(gUniverse - Universes + 1) % universeCount]);
+            updateButtonSprites();
+            break;
+        case SDLK_p: selectPattern(event->key.keysym.mod & KMOD_SHIFT ? -1 : 1);
+            break;
+        // Turn the pattern about to be stamped, or else the selected cells
+        case SDLK_r: if(gStampPattern != NULL)
+            {
+                gStampOrientation = rotateOrientation(gStampOrientation);
+            }
+            else
             {
-                cell->alive = 0;
+                turnSelection(rotateOrientation(0));
+            }
+            break;
+        case SDLK_f: if(gStampPattern != NULL)
+            {
+                gStampOrientation = mirrorOrientation(gStampOrientation);
             }
             else
             {
-                cell->alive = 1;
+                turnSelection(mirrorOrientation(0));
+            }
+            break;
+        case SDLK_ESCAPE: gStampPattern = NULL;
+            gSelection.w = 0;
+            break;
+        case SDLK_c: if(ctrl && gSelection.w > 0)
+            {
+                setClipboard(copyRegion(gUniverse, &gSelection));
+            }
+            break;
+        case SDLK_x: if(ctrl && gSelection.w > 0 && setClipboard(copyRegion(gUniverse, &gSelection)))
+            {
+                queueRegion(gUniverse, CMDFILL, &gSelection, 0);
+            }
+            break;
+        case SDLK_v: if(ctrl && Clipboard.cells[0] != NULL)
+            {
+                gStampPattern = &Clipboard;
+                gStampOrientation = 0;
+            }
+            break;
+        // Undo and redo stop the universe first, so stepping does not bury the edits
+        case SDLK_z: if(ctrl)
+            {
+                gUniverse->play = 0;
+                updateButtonSprites();
+
+                queueCommand(gUniverse, event->key.keysym.mod & KMOD_SHIFT ? CMDREDO : CMDUNDO, 0);
+            }
+            break;
+        case SDLK_y: if(ctrl)
+            {
+                gUniverse->play = 0;
+                updateButtonSprites();
+                queueCommand(gUniverse, CMDREDO, 0);
+            }
+            break;
+        case SDLK_DELETE:
+        case SDLK_BACKSPACE: queueRegion(gUniverse, CMDFILL, &gSelection, 0);
+            break;
+        case SDLK_n: queueRegion(gUniverse, CMDFILL, &gSelection, gFillDensity);
+            break;
+        case SDLK_LEFTBRACKET: gFillDensity = gFillDensity > DENSITYSTEP ? gFillDensity - DENSITYSTEP : DENSITYSTEP;
+            requestRedraw();
+            break;
+        case SDLK_RIGHTBRACKET: gFillDensity = gFillDensity < 100 - DENSITYSTEP ? gFillDensity + DENSITYSTEP : 100;
+            requestRedraw();
+            break;
+    }
+}
+
+void selectPattern(int step)
+{
+    int index = 0;
+
+    // Cycle through the library, the first press picks the first (or last) pattern
+    if(gStampPattern != NULL && gStampPattern != &Clipboard)
+    {
+        index = (int)(gStampPattern - Patterns) + step;
+    }
+    else if(step < 0)
+    {
+        index = patternCount - 1;
+    }
+
+    gStampPattern = &Patterns[(index + patternCount) % patternCount];
+}
+
+void updateCameraInput(SDL_Event *event)
+{
+    // Zoom around the mouse pointer with the mouse wheel
+    if(event->type == SDL_MOUSEWHEEL && event->wheel.y != 0)
+    {
+        zoomCamera(pow(ZOOMSTEP, event->wheel.y), gMouseX - gUniverse->pane.x, gMouseY - gUniverse->pane.y);
+        resizeGrid();
+    }
+
+    // Pan by dragging with the right or middle mouse button
+    if(event->type == SDL_MOUSEBUTTONDOWN && (event->button.button == SDL_BUTTON_RIGHT || event->button.button == SDL_BUTTON_MIDDLE))
+    {
+        gPanning = 1;
+    }
+
+    if(event->type == SDL_MOUSEBUTTONUP && (event->button.button == SDL_BUTTON_RIGHT || event->button.button == SDL_BUTTON_MIDDLE))
+    {
+        gPanning = 0;
+    }
+
+    // Keyboard zoom and pan
+    if(event->type == SDL_KEYDOWN)
+    {
+        switch(event->key.keysym.sym)
+        {
+            case SDLK_EQUALS:
+            case SDLK_PLUS:
+            case SDLK_KP_PLUS: zoomCamera(ZOOMSTEP, gCamera.viewW / 2, gCamera.viewH / 2);
+                resizeGrid();
+                break;
+            case SDLK_MINUS:
+            case SDLK_KP_MINUS: zoomCamera(1.0 / ZOOMSTEP, gCamera.viewW / 2, gCamera.viewH / 2);
+                resizeGrid();
+                break;
+            case SDLK_HOME: resetCamera();
+                resizeGrid();
+                break;
+            case SDLK_LEFT: panCamera(gCamera.viewW / PANSTEP, 0);
+                clampCamera();
+                break;
+            case SDLK_RIGHT: panCamera(-gCamera.viewW / PANSTEP, 0);
+                clampCamera();
+                break;
+            case SDLK_UP: panCamera(0, gCamera.viewH / PANSTEP);
+                clampCamera();
+                break;
+            case SDLK_DOWN: panCamera(0, -gCamera.viewH / PANSTEP);
+                clampCamera();
+                break;
+        }
+    }
+}
+
+void updateGridInput(SDL_Event *event)
+{
+    int x;
+    int y;
+
+    // Shift and left drag selects a rectangle of cells
+    if(event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT && (SDL_GetModState() & KMOD_SHIFT))
+    {
+        if(selectedCell(&x, &y))
+        {
+            gSelecting = 1;
+            gSelectX = x;
+            gSelectY = y;
+            selectCells(x, y);
+        }
+    }
+    else if(event->type == SDL_MOUSEMOTION && gSelecting)
+    {
+        if(selectedCell(&x, &y))
+        {
+            selectCells(x, y);
+        }
+    }
+    else if(event->type == SDL_MOUSEBUTTONUP && event->button.button == SDL_BUTTON_LEFT && gSelecting)
+    {
+        gSelecting = 0;
+    }
+    // Left click stamps the armed pattern centred on the cell
+    else if(event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT && gStampPattern != NULL)
+    {
+        if(selectedCell(&x, &y))
+        {
+            Board *cells = patternCells(gStampPattern, gStampOrientation);
+            queueStamp(gUniverse, gStampPattern, gStampOrientation, x - cells->w / 2, y - cells->h / 2);
+        }
+    }
+    // Left click toggles a cell, and dragging paints the same state along the stroke
+    else if(event->type == SDL_MOUSEBUTTONDOWN && event->button.button == SDL_BUTTON_LEFT)
+    {
+        if(selectedCell(&x, &y))
+        {
+            // The whole stroke is undone in one go
+            queueCommand(gUniverse, CMDJOURNAL, 0);
+            gPainting = 1;
+            gPaintX = x;
+            gPaintY = y;
+            queuePaint(gUniverse, x, y, x, y, PAINTTOGGLE);
+        }
+    }
+    else if(event->type == SDL_MOUSEBUTTONUP && event->button.button == SDL_BUTTON_LEFT)
+    {
+        if(gPainting)
+        {
+            queueCommand(gUniverse, CMDJOURNAL, 0);
+        }
+
+        gPainting = 0;
+    }
+    else if(event->type == SDL_MOUSEMOTION && gPainting && (event->motion.state & SDL_BUTTON_LMASK))
+    {
+        if(selectedCell(&x, &y))
+        {
+            // Resume a stroke that left the grid from where it re-entered
+            if(gPaintX < 0)
+            {
+                gPaintX = x;
+                gPaintY = y;
+            }
+
+            if(x != gPaintX || y != gPaintY)
+            {
+                queuePaint(gUniverse, gPaintX, gPaintY, x, y, PAINTSTROKE);
+                gPaintX = x;
+                gPaintY = y;
             }
         }
+        else
+        {
+            gPaintX = -1;
+            gPaintY = -1;
+        }
     }
 }
 
+void turnSelection(int orientation)
+{
+    if(!clipRegion(gUniverse, &gSelection))
+    {
+        return;
+    }
+
+    queueRegion(gUniverse, CMDTRANSFORM, &gSelection, orientation);
+
+    // The selection keeps its top left corner and takes the turned shape
+    if(orientation & ORIENTTRANSPOSE)
+    {
+        int w = gSelection.w;
+        gSelection.w = gSelection.h;
+        gSelection.h = w;
+        clipRegion(gUniverse, &gSelection);
+    }
+}
+
+void selectCells(int x, int y)
+{
+    // The selection spans from the cell the drag started on to this one, inclusive
+    gSelection.x = x < gSelectX ? x : gSelectX;
+    gSelection.y = y < gSelectY ? y : gSelectY;
+    gSelection.w = abs(x - gSelectX) + 1;
+    gSelection.h = abs(y - gSelectY) + 1;
+}
+
 void drawButtons()
 {
     drawSprite(playButton.sprite, playButton.box.x, playButton.box.y, 0, SDL_FLIP_NONE);
@@ -522,6 +851,9 @@ void drawButtons()
     {
         drawSprite(highlightButtonSprite, highlightButton->box.x, highlightButton->box.y, 0, SDL_FLIP_NONE);
     }
+
+    // Performance overlay sits to the right of the buttons
+    drawHud(quitButton.box.x + quitButton.box.w + BUTTONSPACINGX, quitButton.box.y - 1);
 }
 
 int mouseCollide(SDL_Rect *box)
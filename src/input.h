@@ -26,11 +26,21 @@ typedef struct BUTTON_S
 } Button;
 
 void initInput();
+void updateButtonSprites();
 int loadButtonSprites();
 void positionButtons(int x, int y);
 void updateInput();
-void updateButtons();
-void updateGridInput();
+int waitInput(int timeout);
+int leftButton(SDL_Event *event, Uint32 type);
+void updateButtons(SDL_Event *event);
+void stopUniverses();
+void restartUniverses();
+void updateKeyInput(SDL_Event *event);
+void selectPattern(int step);
+void updateCameraInput(SDL_Event *event);
+void updateGridInput(SDL_Event *event);
+void turnSelection(int orientation);
+void selectCells(int x, int y);
 void drawButtons();
 int mouseCollide(SDL_Rect *box);
 void closeInput();
@@ -0,0 +1,307 @@
+// ###########################################################################
+//          Title: YaGoL Journal Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Undo and redo history of a board, kept as the cells that
+//                 changed between one entry and the next.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "journal.h"
+#include "checkpoint.h"
+
+#define PACKEDTILEBYTES (JOURNALTILEROWS * 10) // Worst case of packWords for one tile
+
+int initJournal(Journal *journal, Board *board)
+{
+    // Forget any history and start over from the board as it is now
+    dropEntries(journal, 0, journal->total);
+
+    if(journal->shadow == NULL)
+    {
+        journal->shadow = createBoard(board->w, board->h);
+        journal->entries = malloc(sizeof(JournalEntry) * JOURNALMAXENTRIES);
+        if(journal->shadow == NULL || journal->entries == NULL)
+        {
+            printf("Unable to allocate journal!\n");
+            closeJournal(journal);
+            return 0;
+        }
+    }
+
+    copyBoard(journal->shadow, board);
+
+    return 1;
+}
+
+int commitJournal(Journal *journal, Board *board)
+{
+    if(journal->shadow == NULL)
+    {
+        return 0;
+    }
+
+    long flips = 0;
+    size_t words = (size_t)board->h * board->stride;
+
+    for(size_t i = 0; i < words; i++)
+    {
+        flips += __builtin_popcountll(board->cells[i] ^ journal->shadow->cells[i]);
+    }
+
+    if(flips == 0)
+    {
+        return 1;
+    }
+
+    // A few scattered cells are cheapest as a list, anything bigger as packed tiles
+    JournalEntry entry;
+    int made = diffTiles(board, journal->shadow, &entry);
+
+    if(made && (size_t)flips * sizeof(Uint32) < entry.size)
+    {
+        free(entry.data);
+        made = diffFlips(board, journal->shadow, flips, &entry);
+    }
+
+    copyBoard(journal->shadow, board);
+
+    if(!made)
+    {
+        printf("Unable to journal %li changed cells!\n", flips);
+        return 0;
+    }
+
+    // A new change replaces whatever could have been redone
+    dropEntries(journal, journal->count, journal->total);
+
+    if(journal->count == JOURNALMAXENTRIES)
+    {
+        dropEntries(journal, 0, 1);
+    }
+
+    journal->entries[journal->count++] = entry;
+    journal->total = journal->count;
+    journal->bytes += entry.size;
+
+    while(journal->bytes > JOURNALBYTES && journal->count > 1)
+    {
+        dropEntries(journal, 0, 1);
+    }
+
+    return 1;
+}
+
+int undoJournal(Journal *journal, Board *board)
+{
+    // Changes since the last entry (generations stepped, say) are undone first
+    if(!commitJournal(journal, board) || journal->count == 0)
+    {
+        return 0;
+    }
+
+    JournalEntry *entry = &journal->entries[--journal->count];
+
+    return applyEntry(entry, board) && applyEntry(entry, journal->shadow);
+}
+
+int redoJournal(Journal *journal, Board *board)
+{
+    // Any change since the last undo starts a new history, and there is nothing left to redo
+    if(!commitJournal(journal, board) || journal->count == journal->total)
+    {
+        return 0;
+    }
+
+    JournalEntry *entry = &journal->entries[journal->count++];
+
+    return applyEntry(entry, board) && applyEntry(entry, journal->shadow);
+}
+
+int diffTiles(Board *a, Board *b, JournalEntry *entry)
+{
+    int tilesY = (a->h + JOURNALTILEROWS - 1) / JOURNALTILEROWS;
+    int changed = 0;
+
+    // Count the changed tiles first so the worst case can be allocated in one go
+    for(int ty = 0; ty < tilesY; ty++)
+    {
+        for(int tx = 0; tx < a->stride; tx++)
+        {
+            for(int y = ty * JOURNALTILEROWS; y < (ty + 1) * JOURNALTILEROWS && y < a->h; y++)
+            {
+                if(BOARDWORD(a, tx << 6, y) != BOARDWORD(b, tx << 6, y))
+                {
+                    changed++;
+                    break;
+                }
+            }
+        }
+    }
+
+    entry->kind = JOURNALTILES;
+    entry->count = 0;
+    entry->size = 0;
+    entry->data = malloc((size_t)changed * (2 * sizeof(Uint32) + PACKEDTILEBYTES));
+    if(entry->data == NULL)
+    {
+        return 0;
+    }
+
+    Uint64 tile[JOURNALTILEROWS];
+
+    for(int ty = 0; ty < tilesY; ty++)
+    {
+        for(int tx = 0; tx < a->stride; tx++)
+        {
+            Uint64 any = 0;
+
+            for(int i = 0; i < JOURNALTILEROWS; i++)
+            {
+                int y = ty * JOURNALTILEROWS + i;
+
+                tile[i] = y < a->h ? BOARDWORD(a, tx << 6, y) ^ BOARDWORD(b, tx << 6, y) : 0;
+                any |= tile[i];
+            }
+
+            if(any == 0)
+            {
+                continue;
+            }
+
+            Uint32 header[2];
+            header[0] = (Uint32)(ty * a->stride + tx);
+            header[1] = (Uint32)packWords(tile, JOURNALTILEROWS, entry->data + entry->size + sizeof(header));
+
+            memcpy(entry->data + entry->size, header, sizeof(header));
+            entry->size += sizeof(header) + header[1];
+            entry->count++;
+        }
+    }
+
+    // Give back what the packing saved
+    Uint8 *data = realloc(entry->data, entry->size > 0 ? entry->size : 1);
+    if(data != NULL)
+    {
+        entry->data = data;
+    }
+
+    return 1;
+}
+
+int diffFlips(Board *a, Board *b, long flips, JournalEntry *entry)
+{
+    Uint32 *cells = malloc(sizeof(Uint32) * flips);
+    if(cells == NULL)
+    {
+        return 0;
+    }
+
+    entry->kind = JOURNALFLIPS;
+    entry->count = 0;
+    entry->size = sizeof(Uint32) * flips;
+    entry->data = (Uint8*)cells;
+
+    // Cells are numbered row by row across the whole stride
+    for(int y = 0; y < a->h; y++)
+    {
+        for(int word = 0; word < a->stride; word++)
+        {
+            Uint64 bits = BOARDWORD(a, word << 6, y) ^ BOARDWORD(b, word << 6, y);
+
+            while(bits != 0)
+            {
+                cells[entry->count++] = (Uint32)((size_t)y * a->stride * 64 + (word << 6) + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int applyEntry(JournalEntry *entry, Board *board)
+{
+    if(entry->kind == JOURNALFLIPS)
+    {
+        Uint32 *cells = (Uint32*)entry->data;
+
+        for(int i = 0; i < entry->count; i++)
+        {
+            board->cells[cells[i] >> 6] ^= (Uint64)1 << (cells[i] & 63);
+        }
+
+        return 1;
+    }
+
+    Uint64 tile[JOURNALTILEROWS];
+    size_t pos = 0;
+
+    for(int i = 0; i < entry->count; i++)
+    {
+        Uint32 header[2];
+
+        memcpy(header, entry->data + pos, sizeof(header));
+        pos += sizeof(header);
+
+        size_t end = pos + header[1];
+        if(end > entry->size || !unpackWords(entry->data, end, &pos, tile, JOURNALTILEROWS))
+        {
+            printf("Journal entry is corrupt!\n");
+            return 0;
+        }
+
+        int tx = header[0] % board->stride;
+        int ty = header[0] / board->stride;
+
+        for(int r = 0; r < JOURNALTILEROWS && ty * JOURNALTILEROWS + r < board->h; r++)
+        {
+            BOARDWORD(board, tx << 6, ty * JOURNALTILEROWS + r) ^= tile[r];
+        }
+    }
+
+    return 1;
+}
+
+void dropEntries(Journal *journal, int first, int last)
+{
+    if(last <= first)
+    {
+        return;
+    }
+
+    for(int i = first; i < last; i++)
+    {
+        journal->bytes -= journal->entries[i].size;
+        free(journal->entries[i].data);
+    }
+
+    memmove(&journal->entries[first], &journal->entries[last], sizeof(JournalEntry) * (journal->total - last));
+
+    // Entries that could be undone shift down along with the rest
+    journal->count -= journal->count > first ? (journal->count < last ? journal->count : last) - first : 0;
+    journal->total -= last - first;
+}
+
+void closeJournal(Journal *journal)
+{
+    if(journal->entries != NULL)
+    {
+        dropEntries(journal, 0, journal->total);
+    }
+
+    free(journal->entries);
+    freeBoard(journal->shadow);
+    journal->entries = NULL;
+    journal->shadow = NULL;
+    journal->count = 0;
+    journal->total = 0;
+    journal->bytes = 0;
+}
@@ -0,0 +1,60 @@
+// ###########################################################################
+//          Title: YaGoL Journal Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Undo and redo history of a board, kept as the cells that
+//                 changed between one entry and the next.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "engine.h"
+
+#define JOURNALTILEROWS 64 // Bulk changes are kept in tiles one word wide and this many rows tall
+#define JOURNALBYTES (64 << 20) // Oldest entries are dropped to keep the history under this size
+#define JOURNALMAXENTRIES 1024
+
+enum JOURNALKIND
+{
+    JOURNALFLIPS = 0, // A list of cells that flipped
+    JOURNALTILES = 1 // Tiles that changed, each packed with packWords
+};
+
+// Applying an entry XORs it into the board, so the same entry both undoes and redoes
+typedef struct JOURNALENTRY_S
+{
+    int kind;
+    int count; // Cells or tiles in data
+    size_t size; // Bytes in data
+    Uint8 *data; // Uint32 cell indices, or for each tile its Uint32 index, packed size and packed words
+} JournalEntry;
+
+typedef struct JOURNAL_S
+{
+    Board *shadow; // Cells as of the newest entry, anything since then is not in the journal yet
+    JournalEntry *entries; // Entries that can be undone, followed by those that can be redone
+    int count; // Entries that can be undone
+    int total; // Entries including those that can be redone
+    size_t bytes; // Held by the data of all entries
+} Journal;
+
+int initJournal(Journal *journal, Board *board);
+int commitJournal(Journal *journal, Board *board);
+int undoJournal(Journal *journal, Board *board);
+int redoJournal(Journal *journal, Board *board);
+int diffTiles(Board *a, Board *b, JournalEntry *entry);
+int diffFlips(Board *a, Board *b, long flips, JournalEntry *entry);
+int applyEntry(JournalEntry *entry, Board *board);
+void dropEntries(Journal *journal, int first, int last);
+void closeJournal(Journal *journal);
+
+#endif
@@ -0,0 +1,108 @@
+// ###########################################################################
+//          Title: YaGoL Stepping Kernel
+//         Author: Mike Del Pozzo
+//    Description: Steps 64 cells at a time with bitwise adders. This file
+//                 is compiled once per instruction set with KERNELNAME set
+//                 to the name of that variant (see the Makefile).
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "engine.h"
+
+#ifndef KERNELNAME
+#define KERNELNAME stepRowsGeneric
+#endif
+
+// Next state of 64 cells from their 8 neighbor words and the cells themselves
+static inline Uint64 lifeWord(Uint64 aw, Uint64 a, Uint64 ae, Uint64 bw, Uint64 b, Uint64 be, Uint64 cw, Uint64 c, Uint64 ce)
+{
+    // Add each row of neighbors into a ones bit and a twos bit
+    Uint64 s1 = aw ^ a ^ ae;
+    Uint64 c1 = (aw & a) | (ae & (aw ^ a));
+    Uint64 s2 = bw ^ be;
+    Uint64 c2 = bw & be;
+    Uint64 s3 = cw ^ c ^ ce;
+    Uint64 c3 = (cw & c) | (ce & (cw ^ c));
+
+    // Add the ones bits, which carries into a fourth twos bit
+    Uint64 s = s1 ^ s2 ^ s3;
+    Uint64 c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+
+    // The count is 2 or 3 exactly when one of the four twos bits is set
+    Uint64 t = c1 ^ c2 ^ c3;
+    Uint64 t2 = (c1 & c2) | (c3 & (c1 ^ c2));
+
+    return ~t2 & (t ^ c4) & (s | b);
+}
+
+// Neighbor words for word i of a row, with the cells past the right edge read as dead
+static inline void loadEdge(const Uint64 *r, int i, int words, int w, Uint64 lastMask, int wrap, Uint64 *west, Uint64 *cur, Uint64 *east)
+{
+    Uint64 c = r[i] & (i == words - 1 ? lastMask : ~(Uint64)0);
+    Uint64 prev = i > 0 ? r[i - 1] : 0;
+    Uint64 next = i < words - 1 ? r[i + 1] & (i + 1 == words - 1 ? lastMask : ~(Uint64)0) : 0;
+
+    *west = (c << 1) | (prev >> 63);
+    *cur = c;
+    *east = (c >> 1) | (next << 63);
+
+    if(wrap && i == 0)
+    {
+        *west |= (r[words - 1] >> ((w - 1) & 63)) & 1;
+    }
+
+    if(wrap && i == words - 1)
+    {
+        *east |= (r[0] & 1) << ((w - 1) & 63);
+    }
+}
+
+void KERNELNAME(const Uint64 *src, Uint64 *dst, const Uint64 *zero, int stride, int w, int h, int wrap, int y0, int y1)
+{
+    int words = (w + 63) / 64;
+    Uint64 lastMask = w % 64 ? ((Uint64)1 << (w % 64)) - 1 : ~(Uint64)0;
+
+    for(int y = y0; y < y1; y++)
+    {
+        const Uint64 *b = src + (size_t)y * stride;
+        const Uint64 *a = y > 0 ? b - stride : (wrap ? src + (size_t)(h - 1) * stride : zero);
+        const Uint64 *c = y < h - 1 ? b + stride : (wrap ? src : zero);
+        Uint64 *out = dst + (size_t)y * stride;
+
+        // Words in the middle of the row need no edge handling, so this loop vectorizes
+        for(int i = 1; i < words - 1; i++)
+        {
+            out[i] = lifeWord((a[i] << 1) | (a[i - 1] >> 63), a[i], (a[i] >> 1) | (a[i + 1] << 63),
+                              (b[i] << 1) | (b[i - 1] >> 63), b[i], (b[i] >> 1) | (b[i + 1] << 63),
+                              (c[i] << 1) | (c[i - 1] >> 63), c[i], (c[i] >> 1) | (c[i + 1] << 63));
+        }
+
+        // First and last words of the row
+        for(int i = 0; i < words; i += words - 1 > 0 ? words - 1 : 1)
+        {
+            Uint64 aw, ac, ae, bw, bc, be, cw, cc, ce;
+
+            loadEdge(a, i, words, w, lastMask, wrap, &aw, &ac, &ae);
+            loadEdge(b, i, words, w, lastMask, wrap, &bw, &bc, &be);
+            loadEdge(c, i, words, w, lastMask, wrap, &cw, &cc, &ce);
+
+            Uint64 next = lifeWord(aw, ac, ae, bw, bc, be, cw, cc, ce);
+
+            // Cells past the right edge are not part of the region and are left as they were
+            if(i == words - 1)
+            {
+                next = (next & lastMask) | (b[i] & ~lastMask);
+            }
+
+            out[i] = next;
+        }
+    }
+}
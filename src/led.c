@@ -0,0 +1,133 @@
+// ###########################################################################
+//          Title: YaGoL LED Generator
+//         Author: Mike Del Pozzo
+//    Description: Renders LED cell sprites procedurally at any pixel size
+//                 and caches them per size in the sprite atlas.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include <math.h>
+#include "led.h"
+
+// Center and rim colors of each LED, sampled from the hand-drawn sprites
+Uint8 ledCenter[LEDOFF + 1][3] =
+{
+    { 249, 3, 8 }, // red
+    { 16, 229, 0 }, // green
+    { 68, 110, 204 }, // blue
+    { 189, 0, 204 }, // purple
+    { 212, 225, 0 }, // yellow
+    { 64, 50, 46 } // off
+};
+
+Uint8 ledRim[LEDOFF + 1][3] =
+{
+    { 102, 3, 1 },
+    { 3, 93, 0 },
+    { 35, 53, 137 },
+    { 81, 0, 83 },
+    { 101, 112, 0 },
+    { 16, 7, 2 }
+};
+
+char *ledNames[LEDHIGHLIGHT + 1] = { "red", "green", "blue", "purple", "yellow", "off", "highlight" };
+
+Sprite* ledSprite(int led, int size)
+{
+    char name[64];
+
+    if(size < 1)
+    {
+        size = 1;
+    }
+
+    if(size > MAXLEDSIZE)
+    {
+        size = MAXLEDSIZE;
+    }
+
+    // Generated sprites live in the sprite list under a name per kind and size
+    snprintf(name, sizeof(name), "led/%s/%i", ledNames[led], size);
+
+    Sprite *sprite = findSprite(name);
+    if(sprite != NULL)
+    {
+        return sprite;
+    }
+
+    SDL_Surface *surface = renderLed(led, size);
+    if(surface == NULL)
+    {
+        return NULL;
+    }
+
+    sprite = createSprite(name, surface);
+    SDL_FreeSurface(surface);
+
+    return sprite;
+}
+
+SDL_Surface* renderLed(int led, int size)
+{
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    if(surface == NULL)
+    {
+        printf("Unable to create LED surface! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    SDL_LockSurface(surface);
+
+    double radius = size / 2.0;
+    int border = size / 10 > 0 ? size / 10 : 1;
+
+    for(int y = 0; y < size; y++)
+    {
+        Uint32 *row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+
+        for(int x = 0; x < size; x++)
+        {
+            if(led == LEDHIGHLIGHT)
+            {
+                // Highlight is a white frame around the cell
+                int edge = x < border || y < border || x >= size - border || y >= size - border;
+                row[x] = edge ? 0xFFFFFFFF : 0x00000000;
+                continue;
+            }
+
+            double dx = (x + 0.5 - radius) / radius;
+            double dy = (y + 0.5 - radius) / radius;
+            double d = sqrt(dx * dx + dy * dy);
+
+            // Radial falloff from the center color to the rim color, with a
+            // soft specular spot toward the top left
+            double t = d < 1.0 ? d * d : 1.0;
+            double hx = dx + 0.35;
+            double hy = dy + 0.35;
+            double spot = 1.0 - sqrt(hx * hx + hy * hy) / 0.35;
+            spot = (led != LEDOFF && spot > 0 && d < 1.0) ? spot * 0.6 : 0;
+
+            Uint32 pixel = 0xFF000000;
+            for(int c = 0; c < 3; c++)
+            {
+                double value = ledCenter[led][c] + (ledRim[led][c] - ledCenter[led][c]) * t;
+                value += (255 - value) * spot;
+                pixel |= (Uint32)value << (16 - c * 8);
+            }
+
+            row[x] = pixel;
+        }
+    }
+
+    SDL_UnlockSurface(surface);
+
+    return surface;
+}
@@ -0,0 +1,35 @@
+// ###########################################################################
+//          Title: YaGoL LED Generator
+//         Author: Mike Del Pozzo
+//    Description: Renders LED cell sprites procedurally at any pixel size
+//                 and caches them per size in the sprite atlas.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef LED_H
+#define LED_H
+
+#include "graphics.h"
+#include "grid.h"
+
+#define MAXLEDSIZE 256 // Largest LED that will be generated, in pixels
+
+// LED kinds, the live colors share their values with CELLCOLORS
+enum LEDKIND
+{
+    LEDOFF = RANDOMCELL,
+    LEDHIGHLIGHT = RANDOMCELL + 1
+};
+
+Sprite* ledSprite(int led, int size);
+SDL_Surface* renderLed(int led, int size);
+
+#endif
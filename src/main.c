@@ -17,25 +17,129 @@
 #include "graphics.h"
 #include "grid.h"
 #include "input.h"
+#include "camera.h"
+#include "hud.h"
+#include "trace.h"
+#include "engine.h"
+#include "workers.h"
+#include "conformance.h"
+#include "distributed.h"
+#include "server.h"
+#include "client.h"
+#include "patterns.h"
+#include "tiles.h"
+#include "census.h"
+#include "commands.h"
+
+#define IDLETIMEOUT 250 // How long to sleep between checks for grid changes while idle (ms)
+#define CLIENTTIMEOUT 5 // How long a viewer sleeps between checks for new generations (ms)
+#define MAXSTAMPS 64 // Patterns that can be placed from the command line
 
 extern SDL_Renderer *gRenderer;
 extern int gQuit;
-extern int gPlay;
+extern int gRedraw;
+extern Engine *gEngine;
+extern int gClientMode;
+extern int gFusedRender;
 
 Sprite *bgSprite = NULL;
+int drawnVersion = -1; // Grid version shown by the last drawn frame
 
 void loop()
 {
+    if(gClientMode)
+    {
+        Uint64 trace = traceBegin();
+        pollClient();
+        traceEnd("pollClient", trace);
+    }
+
+    // Edits queued by the last frame's input go in between generations
+    if(pendingCommands())
+    {
+        Uint64 trace = traceBegin();
+        applyCommands();
+        traceEnd("applyCommands", trace);
+
+        // Buttons show what the applied commands left, such as a new color
+        updateButtonSprites();
+    }
+
+    // While stopped with nothing new to show, sleep until something
+    // happens instead of redrawing the same frame
+    if(!universesPlaying() && !gRedraw && gridVersion() == drawnVersion)
+    {
+        if(!waitInput(gClientMode ? CLIENTTIMEOUT : IDLETIMEOUT))
+        {
+            return;
+        }
+    }
+
+    gRedraw = 0;
+
+    Uint64 trace = traceBegin();
+    Uint64 start = hudTimer();
     clearScreen();
+    traceEnd("clearScreen", trace);
+
+    trace = traceBegin();
     drawBackground(bgSprite);
-    if(gPlay)
+    traceEnd("drawBackground", trace);
+    hudAddRender(start);
+
+    if(universesPlaying())
     {
-        updateGrid();
+        trace = traceBegin();
+        stepUniverses();
+        traceEnd("stepUniverses", trace);
     }
+
+    trace = traceBegin();
+    start = hudTimer();
     drawGrid();
+    hudAddRender(start);
+    traceEnd("drawGrid", trace);
+    drawnVersion = gridVersion();
+
+    trace = traceBegin();
     updateInput();
+    traceEnd("updateInput", trace);
+
+    trace = traceBegin();
+    start = hudTimer();
     drawButtons();
+    hudAddRender(start);
+    traceEnd("drawButtons", trace);
+
+    trace = traceBegin();
     nextFrame();
+    traceEnd("nextFrame", trace);
+    endHudFrame();
+}
+
+int placeStamp(char *arg)
+{
+    // Patterns are given as NAME:X,Y or NAME:X,Y:ORIENTATION
+    char name[32];
+    int x = 0;
+    int y = 0;
+    int orientation = 0;
+
+    if(sscanf(arg, "%31[^:]:%i,%i:%i", name, &x, &y, &orientation) < 3)
+    {
+        printf("Unable to read stamp %s, expected NAME:X,Y[:ORIENTATION]\n", arg);
+        return 0;
+    }
+
+    Pattern *pattern = findPattern(name);
+    if(pattern == NULL)
+    {
+        printf("Unknown pattern %s\n", name);
+        return 0;
+    }
+
+    stampCells(gUniverse, pattern, orientation, x, y);
+    return 1;
 }
 
 int main(int argc, char * argv[])
@@ -43,22 +147,362 @@ int main(int argc, char * argv[])
     time_t t;
     srand((unsigned) time(&t));
 
+    int frameStats = 0;
+    char *traceFile = NULL;
+    int pacing = PACETIMER;
+    int fps = 0;
+    char *engineName = "auto";
+    int threads = 0;
+    int benchmark = 0;
+    int benchSize = BENCHSIZE;
+    int conformance = 0;
+    int coordinator = 0;
+    char *workerAddress = NULL;
+    DistConfig dist = { 0, 2, 2, 1024, 1024, 1000, 0, 1, 0, 0, NULL, 0, argv[0], 0 };
+    int serverPort = 0;
+    int serverRate = 30;
+    int serverGenerations = 0;
+    char *serverAddress = NULL;
+    char *tileFile = NULL;
+    CheckpointConfig checkpoints = { NULL, 0, 0, 3 };
+    char *restoreFile = NULL;
+    char *stamps[MAXSTAMPS];
+    int stampCount = 0;
+    int stampBench = 0;
+    int universes = 1;
+    int densities[MAXUNIVERSES] = { 50, 50, 50, 50 };
+    long censusSoups = 0;
+    char *censusFile = "census.txt";
+    char *exportName = NULL;
+    int exportSlots = EXPORTSLOTS;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--vsync") == 0)
+        {
+            pacing = PACEVSYNC;
+        }
+        else if(strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+        {
+            fps = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--frame-stats") == 0)
+        {
+            frameStats = 1;
+        }
+        else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            traceFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+        {
+            engineName = argv[++i];
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+        {
+            benchmark = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--bench-size") == 0 && i + 1 < argc)
+        {
+            benchSize = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--conformance") == 0)
+        {
+            conformance = 1;
+        }
+        else if(strcmp(argv[i], "--coordinator") == 0 && i + 1 < argc)
+        {
+            coordinator = 1;
+            dist.port = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--worker") == 0 && i + 1 < argc)
+        {
+            workerAddress = argv[++i];
+        }
+        else if(strcmp(argv[i], "--blocks") == 0 && i + 1 < argc)
+        {
+            sscanf(argv[++i], "%ix%i", &dist.blocksX, &dist.blocksY);
+        }
+        else if(strcmp(argv[i], "--universe") == 0 && i + 1 < argc)
+        {
+            sscanf(argv[++i], "%ix%i", &dist.w, &dist.h);
+        }
+        else if(strcmp(argv[i], "--generations") == 0 && i + 1 < argc)
+        {
+            dist.generations = atoi(argv[++i]);
+            serverGenerations = dist.generations;
+        }
+        else if(strcmp(argv[i], "--wrap") == 0)
+        {
+            dist.wrap = 1;
+        }
+        else if(strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            dist.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--spawn") == 0)
+        {
+            dist.spawn = 1;
+        }
+        else if(strcmp(argv[i], "--verify") == 0)
+        {
+            dist.verify = 1;
+        }
+        else if(strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc)
+        {
+            dist.snapshotFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "--snapshot-every") == 0 && i + 1 < argc)
+        {
+            dist.snapshotEvery = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--server") == 0 && i + 1 < argc)
+        {
+            serverPort = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            serverRate = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--connect") == 0 && i + 1 < argc)
+        {
+            serverAddress = argv[++i];
+        }
+        else if(strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpoints.prefix = argv[++i];
+        }
+        else if(strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+        {
+            checkpoints.every = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--checkpoint-seconds") == 0 && i + 1 < argc)
+        {
+            checkpoints.seconds = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--checkpoint-keep") == 0 && i + 1 < argc)
+        {
+            checkpoints.keep = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--restore") == 0 && i + 1 < argc)
+        {
+            restoreFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "--tiles") == 0 && i + 1 < argc)
+        {
+            tileFile = argv[++i];
+        }
+        else if(strcmp(argv[i], "--stamp") == 0 && i + 1 < argc && stampCount < MAXSTAMPS)
+        {
+            stamps[stampCount++] = argv[++i];
+        }
+        else if(strcmp(argv[i], "--stamp-bench") == 0 && i + 1 < argc)
+        {
+            stampBench = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--universes") == 0 && i + 1 < argc)
+        {
+            universes = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--densities") == 0 && i + 1 < argc)
+        {
+            // One percentage per universe, the last one given carries on to the rest
+            char *density = strtok(argv[++i], ",");
+
+            for(int j = 0; j < MAXUNIVERSES; j++)
+            {
+                densities[j] = density != NULL ? atoi(density) : densities[j > 0 ? j - 1 : 0];
+                density = density != NULL ? strtok(NULL, ",") : NULL;
+            }
+        }
+        else if(strcmp(argv[i], "--fused-render") == 0)
+        {
+            gFusedRender = 1;
+        }
+        else if(strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+        {
+            exportName = argv[++i];
+        }
+        else if(strcmp(argv[i], "--export-slots") == 0 && i + 1 < argc)
+        {
+            exportSlots = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--census") == 0 && i + 1 < argc)
+        {
+            censusSoups = atol(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--census-file") == 0 && i + 1 < argc)
+        {
+            censusFile = argv[++i];
+        }
+        else
+        {
+            printf("Usage: %s [--vsync] [--fps N] [--frame-stats] [--trace FILE] [--engine NAME] [--threads N]\n"
+                   "       [--benchmark GENERATIONS] [--bench-size N] [--conformance] [--stamp NAME:X,Y[:ORIENTATION]]...\n"
+                   "       [--universes N] [--densities PERCENT[,PERCENT]...] [--fused-render] [--export NAME [--export-slots N]]\n"
+                   "       [--stamp-bench COUNT]\n"
+                   "       [--coordinator PORT [--blocks BXxBY] [--universe WxH] [--generations N] [--wrap] [--seed N]\n"
+                   "        [--spawn] [--verify] [--snapshot FILE] [--snapshot-every N]] [--worker HOST:PORT]\n"
+                   "       [--server PORT [--universe WxH] [--rate N] [--generations N] [--wrap] [--seed N] [--restore FILE]\n"
+                   "        [--checkpoint PREFIX [--checkpoint-every N] [--checkpoint-seconds N] [--checkpoint-keep N]]] [--connect HOST:PORT]\n"
+                   "       [--tiles FILE [--universe WxH] [--generations N] [--wrap] [--seed N] [--verify]]\n"
+                   "       [--census SOUPS [--census-file FILE] [--seed N]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    gEngine = selectEngine(engineName);
+    if(gEngine == NULL)
+    {
+        return 1;
+    }
+
+    setFramePacing(pacing, fps);
+    initTrace(traceFile);
+    traceThreadName("main");
+    initWorkers(threads);
+
+    // Step a large random board without opening a window, also used to train PGO builds
+    if(benchmark > 0)
+    {
+        int result = runBenchmark(gEngine, benchSize, benchmark);
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    // Check every engine against the reference stepper without opening a window
+    if(conformance)
+    {
+        int result = runConformance();
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    // Step one universe split into blocks over several processes
+    if(coordinator || workerAddress != NULL)
+    {
+        dist.threads = threads;
+        int result = !initNet() ? 1 : coordinator ? runCoordinator(&dist) : runWorker(workerAddress);
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    // Step a universe without a window and stream it to viewers
+    if(serverPort > 0)
+    {
+        ServerConfig server = { serverPort, dist.w, dist.h, dist.wrap, dist.seed, serverRate, serverGenerations, checkpoints, restoreFile,
+                               exportName, exportSlots };
+        int result = !initNet() ? 1 : runServer(&server);
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    // Step a universe kept in a memory-mapped file, resuming it if the file exists
+    if(tileFile != NULL)
+    {
+        TileConfig tiles = { tileFile, dist.w, dist.h, dist.generations, dist.wrap, dist.seed, dist.verify };
+        int result = runTiles(&tiles);
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    if(!initPatterns())
+    {
+        closePatterns();
+        closeWorkers();
+        closeTrace();
+        return 1;
+    }
+
+    // Stamp patterns all over a large board without opening a window
+    if(stampBench > 0)
+    {
+        int result = runStampBenchmark(stampBench);
+        closePatterns();
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    // Run random soups on every thread and count what they settle into
+    if(censusSoups > 0)
+    {
+        CensusConfig census = { censusSoups, dist.seed, censusFile };
+        int result = runCensus(&census);
+        closePatterns();
+        closeWorkers();
+        closeTrace();
+        return result;
+    }
+
+    printf("Stepping with the %s engine on %i threads\n", gEngine->name, workerCount());
+
+    // A viewer shows the one universe of its server
+    initUniverses(serverAddress != NULL ? 1 : universes, densities);
+
     if(initGraphics("YaGoL v1.0.1"))
     {
         initInput();
+        initHud();
+        initCamera();
         initGrid();
         bgSprite = loadSprite("images/bgTile1.png");
 
+        // Start from an empty grid holding only the patterns asked for
+        if(stampCount > 0)
+        {
+            clearCells(gUniverse);
+        }
+
+        for(int i = 0; i < stampCount; i++)
+        {
+            if(!placeStamp(stamps[i]))
+            {
+                gQuit = 1;
+            }
+        }
+
+        // A viewer steps nothing, so it has nothing to export
+        if(exportName != NULL && serverAddress == NULL && !exportUniverses(exportName, exportSlots))
+        {
+            gQuit = 1;
+        }
+
+        // Show a universe stepped by a server instead of the local one
+        if(serverAddress != NULL && !initClient(serverAddress))
+        {
+            gQuit = 1;
+        }
+
         while(!gQuit)
         {
             loop();
         }
 
         bgSprite = NULL;
+
+        if(frameStats)
+        {
+            printFrameStats();
+        }
     }
 
+    closeClient();
     clearGrid();
     closeInput();
+    closeHud();
+    closePatterns();
+    closeWorkers();
+    closeTrace();
     closeGraphics();
     SDL_Quit();
 
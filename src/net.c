@@ -0,0 +1,291 @@
+// ###########################################################################
+//          Title: YaGoL Network Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Thin helpers over TCP sockets and a simple framed
+//                 message format shared by the networked modes.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "net.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+int initNet()
+{
+    // A peer that goes away should show up as a failed send, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    return 1;
+}
+
+int netListen(int port, int *boundPort)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+    {
+        printf("Unable to create socket! %s\n", strerror(errno));
+        return -1;
+    }
+
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0)
+    {
+        printf("Unable to listen on port %i! %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    // Port 0 lets the system pick one, so report what it picked
+    if(boundPort != NULL)
+    {
+        socklen_t len = sizeof(addr);
+        getsockname(fd, (struct sockaddr*)&addr, &len);
+        *boundPort = ntohs(addr.sin_port);
+    }
+
+    return fd;
+}
+
+int netAccept(int listenFd, char *host, int hostLen)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd;
+
+    do
+    {
+        fd = accept(listenFd, (struct sockaddr*)&addr, &len);
+    } while(fd < 0 && errno == EINTR);
+
+    if(fd < 0)
+    {
+        printf("Unable to accept connection! %s\n", strerror(errno));
+        return -1;
+    }
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    if(host != NULL)
+    {
+        inet_ntop(AF_INET, &addr.sin_addr, host, hostLen);
+    }
+
+    return fd;
+}
+
+int netConnect(const char *host, int port)
+{
+    struct addrinfo hints;
+    struct addrinfo *result;
+    char service[16];
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(service, sizeof(service), "%i", port);
+
+    if(getaddrinfo(host, service, &hints, &result) != 0)
+    {
+        printf("Unable to resolve %s!\n", host);
+        return -1;
+    }
+
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if(fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) < 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    freeaddrinfo(result);
+
+    if(fd < 0)
+    {
+        printf("Unable to connect to %s:%i! %s\n", host, port, strerror(errno));
+        return -1;
+    }
+
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    return fd;
+}
+
+int netParseAddress(const char *address, char *host, int hostLen, int *port)
+{
+    const char *colon = strrchr(address, ':');
+
+    // A bare port means this machine
+    if(colon == NULL)
+    {
+        snprintf(host, hostLen, "127.0.0.1");
+        *port = atoi(address);
+    }
+    else
+    {
+        snprintf(host, hostLen, "%.*s", (int)(colon - address), address);
+        *port = atoi(colon + 1);
+    }
+
+    return *port > 0 && *port < 65536;
+}
+
+int netSetNonBlocking(int fd, int nonBlocking)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if(flags < 0)
+    {
+        return 0;
+    }
+
+    flags = nonBlocking ? flags | O_NONBLOCK : flags & ~O_NONBLOCK;
+
+    return fcntl(fd, F_SETFL, flags) == 0;
+}
+
+int netSetSendBuffer(int fd, int bytes)
+{
+    return setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) == 0;
+}
+
+int netSendAll(int fd, const void *data, size_t size)
+{
+    const char *p = data;
+
+    while(size > 0)
+    {
+        ssize_t sent = send(fd, p, size, 0);
+
+        if(sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if(sent <= 0)
+        {
+            return 0;
+        }
+
+        p += sent;
+        size -= sent;
+    }
+
+    return 1;
+}
+
+int netRecvAll(int fd, void *data, size_t size)
+{
+    char *p = data;
+
+    while(size > 0)
+    {
+        ssize_t got = recv(fd, p, size, 0);
+
+        if(got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // 0 means the peer closed the connection
+        if(got <= 0)
+        {
+            return 0;
+        }
+
+        p += got;
+        size -= got;
+    }
+
+    return 1;
+}
+
+int netSendMessage(int fd, Uint32 type, const void *data, Uint32 size)
+{
+    return netSendMessage2(fd, type, data, size, NULL, 0);
+}
+
+int netSendMessage2(int fd, Uint32 type, const void *head, Uint32 headSize, const void *data, Uint32 size)
+{
+    NetHeader header;
+
+    header.type = type;
+    header.size = headSize + size;
+
+    return netSendAll(fd, &header, sizeof(header)) && (headSize == 0 || netSendAll(fd, head, headSize))
+        && (size == 0 || netSendAll(fd, data, size));
+}
+
+void* netRecvMessage(int fd, Uint32 *type, Uint32 *size)
+{
+    NetHeader header;
+
+    if(!netRecvAll(fd, &header, sizeof(header)) || header.size > MAXMESSAGE)
+    {
+        return NULL;
+    }
+
+    // Always allocate at least a byte so an empty payload is not mistaken for an error
+    char *data = malloc(header.size + 1);
+    if(data == NULL)
+    {
+        printf("Unable to allocate %u byte message!\n", header.size);
+        return NULL;
+    }
+
+    if(!netRecvAll(fd, data, header.size))
+    {
+        free(data);
+        return NULL;
+    }
+
+    *type = header.type;
+    *size = header.size;
+
+    return data;
+}
+
+void netClose(int fd)
+{
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+#else
+
+// The networked modes are only built on POSIX systems for now
+int initNet()
+{
+    printf("Networked modes are not supported on this platform!\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,46 @@
+// ###########################################################################
+//          Title: YaGoL Network Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Thin helpers over TCP sockets and a simple framed
+//                 message format shared by the networked modes.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef NET_H
+#define NET_H
+
+#include <SDL2/SDL.h>
+
+#define NETHOSTLEN 64
+#define MAXMESSAGE (256 * 1024 * 1024) // Larger messages are treated as a broken stream
+
+// Every message starts with this header, followed by size bytes of payload
+typedef struct NETHEADER_S
+{
+    Uint32 type;
+    Uint32 size;
+} NetHeader;
+
+int initNet();
+int netListen(int port, int *boundPort);
+int netAccept(int listenFd, char *host, int hostLen);
+int netConnect(const char *host, int port);
+int netParseAddress(const char *address, char *host, int hostLen, int *port);
+int netSetNonBlocking(int fd, int nonBlocking);
+int netSetSendBuffer(int fd, int bytes);
+int netSendAll(int fd, const void *data, size_t size);
+int netRecvAll(int fd, void *data, size_t size);
+int netSendMessage(int fd, Uint32 type, const void *data, Uint32 size);
+int netSendMessage2(int fd, Uint32 type, const void *head, Uint32 headSize, const void *data, Uint32 size);
+void* netRecvMessage(int fd, Uint32 *type, Uint32 *size);
+void netClose(int fd);
+
+#endif
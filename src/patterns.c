@@ -0,0 +1,261 @@
+// ###########################################################################
+//          Title: YaGoL Pattern Subsystem
+//         Author: Mike Del Pozzo
+//    Description: A library of well known patterns, kept as packed cells in
+//                 all 8 orientations and stamped onto boards a word at a time.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include <ctype.h>
+#include "patterns.h"
+
+Pattern Patterns[] =
+{
+    { "block", STILLLIFE, "2o$2o!", { NULL } },
+    { "beehive", STILLLIFE, "b2o$o2bo$b2o!", { NULL } },
+    { "loaf", STILLLIFE, "b2o$o2bo$bobo$2bo!", { NULL } },
+    { "boat", STILLLIFE, "2o$obo$bo!", { NULL } },
+    { "tub", STILLLIFE, "bo$obo$bo!", { NULL } },
+    { "blinker", OSCILLATOR, "3o!", { NULL } },
+    { "toad", OSCILLATOR, "b3o$3o!", { NULL } },
+    { "beacon", OSCILLATOR, "2o$2o$2b2o$2b2o!", { NULL } },
+    { "pulsar", OSCILLATOR, "2b3o3b3o2$o4bobo4bo$o4bobo4bo$o4bobo4bo$2b3o3b3o2$2b3o3b3o$o4bobo4bo$o4bobo4bo$o4bobo4bo2$2b3o3b3o!", { NULL } },
+    { "pentadecathlon", OSCILLATOR, "2bo4bo$2ob4ob2o$2bo4bo!", { NULL } },
+    { "glider", SPACESHIP, "bo$2bo$3o!", { NULL } },
+    { "lwss", SPACESHIP, "bo2bo$o$o3bo$4o!", { NULL } },
+    { "mwss", SPACESHIP, "3bo$bo3bo$o$o4bo$5o!", { NULL } },
+    { "hwss", SPACESHIP, "3b2o$bo4bo$o$o5bo$6o!", { NULL } },
+    { "gosper-gun", GUN, "24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!", { NULL } },
+    { "simkin-gun", GUN, "2o5b2o$2o5b2o2$4b2o$4b2o5$22b2ob2o$21bo5bo$21bo6bo2b2o$21b3o3bo3b2o$26bo4$20b2o$20bo$21b3o$23bo!", { NULL } },
+    { "r-pentomino", METHUSELAH, "b2o$2o$bo!", { NULL } },
+    { "diehard", METHUSELAH, "6bo$2o$bo3b3o!", { NULL } },
+    { "acorn", METHUSELAH, "bo$3bo$2o2b3o!", { NULL } },
+};
+
+int patternCount = sizeof(Patterns) / sizeof(Patterns[0]);
+
+// Pasted like any other pattern, but filled from a selection of the grid
+Pattern Clipboard = { "clipboard", CLIPBOARD, NULL, { NULL } };
+
+int initPatterns()
+{
+    for(int i = 0; i < patternCount; i++)
+    {
+        Pattern *pattern = &Patterns[i];
+
+        pattern->cells[0] = parseRle(pattern->rle);
+        if(pattern->cells[0] == NULL)
+        {
+            printf("Unable to read pattern %s!\n", pattern->name);
+            return 0;
+        }
+
+        // Every orientation is prepared up front so stamping is only a blit
+        for(int o = 1; o < ORIENTATIONS; o++)
+        {
+            pattern->cells[o] = transformBoard(pattern->cells[0], pattern->cells[0]->w, pattern->cells[0]->h, o);
+            if(pattern->cells[o] == NULL)
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+Board* parseRle(char *rle)
+{
+    int w = 0;
+    int h = 1;
+    int x = 0;
+    int run = 0;
+
+    // First pass finds the size, second pass sets the cells
+    for(int pass = 0; pass < 2; pass++)
+    {
+        Board *board = pass == 1 ? createBoard(w, h) : NULL;
+        int y = 0;
+
+        if(pass == 1 && board == NULL)
+        {
+            return NULL;
+        }
+
+        x = 0;
+        run = 0;
+
+        for(char *c = rle; *c != '\0' && *c != '!'; c++)
+        {
+            if(isdigit((unsigned char)*c))
+            {
+                run = run * 10 + (*c - '0');
+                continue;
+            }
+
+            int count = run > 0 ? run : 1;
+            run = 0;
+
+            switch(*c)
+            {
+                case 'b': x += count;
+                    break;
+                case 'o': for(int i = 0; i < count; i++, x++)
+                    {
+                        if(pass == 1)
+                        {
+                            setBoardCell(board, x, y, 1);
+                        }
+                    }
+                    break;
+                case '$': y += count;
+                    x = 0;
+                    break;
+            }
+
+            if(x > w)
+            {
+                w = x;
+            }
+
+            if(y + 1 > h)
+            {
+                h = y + 1;
+            }
+        }
+
+        if(pass == 1)
+        {
+            return board;
+        }
+    }
+
+    return NULL;
+}
+
+Pattern* findPattern(char *name)
+{
+    for(int i = 0; i < patternCount; i++)
+    {
+        if(strcmp(Patterns[i].name, name) == 0)
+        {
+            return &Patterns[i];
+        }
+    }
+
+    return NULL;
+}
+
+Board* patternCells(Pattern *pattern, int orientation)
+{
+    return pattern->cells[orientation & (ORIENTATIONS - 1)];
+}
+
+int rotateOrientation(int orientation)
+{
+    // A quarter turn clockwise is a transpose followed by a horizontal flip
+    int transposed = (orientation & ORIENTFLIPX ? ORIENTFLIPY : 0) | (orientation & ORIENTFLIPY ? ORIENTFLIPX : 0)
+                   | (orientation & ORIENTTRANSPOSE);
+
+    return (transposed ^ ORIENTTRANSPOSE) ^ ORIENTFLIPX;
+}
+
+int mirrorOrientation(int orientation)
+{
+    // Flips are applied after the transpose, so they always act on the placed pattern
+    return orientation ^ ORIENTFLIPX;
+}
+
+void stampPattern(Board *board, int clipW, int clipH, Pattern *pattern, int orientation, int x, int y)
+{
+    Board *cells = patternCells(pattern, orientation);
+
+    // The whole bounding box is copied, so the dead cells of the pattern clear what was there
+    blitBoard(board, x, y, clipW, clipH, cells, 0, 0, cells->w, cells->h, BLITCOPY);
+}
+
+int setClipboard(Board *cells)
+{
+    // The clipboard takes ownership of cells
+    for(int o = 0; o < ORIENTATIONS; o++)
+    {
+        freeBoard(Clipboard.cells[o]);
+        Clipboard.cells[o] = NULL;
+    }
+
+    if(cells == NULL)
+    {
+        return 0;
+    }
+
+    Clipboard.cells[0] = cells;
+
+    for(int o = 1; o < ORIENTATIONS; o++)
+    {
+        Clipboard.cells[o] = transformBoard(cells, cells->w, cells->h, o);
+        if(Clipboard.cells[o] == NULL)
+        {
+            setClipboard(NULL);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int runStampBenchmark(int count)
+{
+    Board *board = createBoard(STAMPBENCHSIZE, STAMPBENCHSIZE);
+    Uint64 state = 0x2545F4914F6CDD1Dull;
+
+    if(board == NULL)
+    {
+        return 1;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for(int i = 0; i < count; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        Pattern *pattern = &Patterns[state % patternCount];
+        int x = (int)((state >> 16) % STAMPBENCHSIZE);
+        int y = (int)((state >> 32) % STAMPBENCHSIZE);
+
+        stampPattern(board, STAMPBENCHSIZE, STAMPBENCHSIZE, pattern, (int)(state >> 60), x, y);
+    }
+
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    printf("Stamped %i patterns onto a %ix%i board in %.2f ms, %li cells alive\n", count, STAMPBENCHSIZE, STAMPBENCHSIZE,
+           ms, countBoardCells(board, STAMPBENCHSIZE, STAMPBENCHSIZE));
+
+    freeBoard(board);
+
+    return 0;
+}
+
+void closePatterns()
+{
+    setClipboard(NULL);
+
+    for(int i = 0; i < patternCount; i++)
+    {
+        for(int o = 0; o < ORIENTATIONS; o++)
+        {
+            freeBoard(Patterns[i].cells[o]);
+            Patterns[i].cells[o] = NULL;
+        }
+    }
+}
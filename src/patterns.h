@@ -0,0 +1,58 @@
+// ###########################################################################
+//          Title: YaGoL Pattern Subsystem
+//         Author: Mike Del Pozzo
+//    Description: A library of well known patterns, kept as packed cells in
+//                 all 8 orientations and stamped onto boards a word at a time.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef PATTERNS_H
+#define PATTERNS_H
+
+#include "engine.h"
+
+#define ORIENTATIONS 8
+#define STAMPBENCHSIZE 4096 // Board size of the stamping benchmark
+
+enum PATTERNKIND
+{
+    STILLLIFE = 0,
+    OSCILLATOR = 1,
+    SPACESHIP = 2,
+    GUN = 3,
+    METHUSELAH = 4,
+    CLIPBOARD = 5 // Cells copied from the grid
+};
+
+typedef struct PATTERN_S
+{
+    char *name;
+    int kind;
+    char *rle; // Run length encoded cells, as used by most Life programs
+    Board *cells[ORIENTATIONS]; // Packed cells in each orientation, see transformBoard
+} Pattern;
+
+extern Pattern Patterns[];
+extern int patternCount;
+extern Pattern Clipboard;
+
+int initPatterns();
+Board* parseRle(char *rle);
+Pattern* findPattern(char *name);
+Board* patternCells(Pattern *pattern, int orientation);
+int rotateOrientation(int orientation);
+int mirrorOrientation(int orientation);
+void stampPattern(Board *board, int clipW, int clipH, Pattern *pattern, int orientation, int x, int y);
+int setClipboard(Board *cells);
+int runStampBenchmark(int count);
+void closePatterns();
+
+#endif
@@ -0,0 +1,404 @@
+// ###########################################################################
+//          Title: YaGoL Server Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Steps a universe without a window and streams every
+//                 generation to connected viewers as a delta against what
+//                 each viewer already has. Viewers that fall behind skip
+//                 generations instead of slowing the server down.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "server.h"
+#include "trace.h"
+
+extern Engine *gEngine;
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+
+volatile sig_atomic_t serverQuit = 0;
+
+void stopServer(int signal)
+{
+    serverQuit = 1;
+}
+
+int runServer(ServerConfig *config)
+{
+    Viewer viewers[MAXVIEWERS];
+    int viewerCount = 0;
+    Board *current = NULL;
+    int generation = 0;
+
+    // A restored universe brings its own size, edges and generation
+    if(config->restoreFile != NULL)
+    {
+        CheckpointHeader header;
+
+        current = readCheckpoint(config->restoreFile, &header);
+        if(current == NULL)
+        {
+            return 1;
+        }
+
+        config->w = header.w;
+        config->h = header.h;
+        config->wrap = header.wrap;
+        generation = (int)header.generation;
+    }
+    else
+    {
+        current = createBoard(config->w, config->h);
+        if(current != NULL)
+        {
+            fillBoardSeeded(current, 0, 0, 0, 0, config->w, config->h, config->seed);
+        }
+    }
+
+    // The spare takes the place of a board while a checkpoint is written from it
+    Board *next = createBoard(config->w, config->h);
+    Board *spare = config->checkpoints.prefix != NULL ? createBoard(config->w, config->h) : NULL;
+    int startGeneration = generation;
+
+    if(current == NULL || next == NULL || (config->checkpoints.prefix != NULL && spare == NULL)
+    || !initCheckpoints(&config->checkpoints, (Uint64)generation))
+    {
+        closeCheckpoints();
+        freeBoard(current);
+        freeBoard(next);
+        freeBoard(spare);
+        return 1;
+    }
+
+    Export export = { 0 };
+    if(config->exportName != NULL && !openExport(&export, config->exportName, config->w, config->h, config->exportSlots))
+    {
+        closeCheckpoints();
+        freeBoard(current);
+        freeBoard(next);
+        freeBoard(spare);
+        return 1;
+    }
+
+    int listenFd = netListen(config->port, NULL);
+    if(listenFd < 0)
+    {
+        closeExport(&export);
+        closeCheckpoints();
+        freeBoard(current);
+        freeBoard(next);
+        freeBoard(spare);
+        return 1;
+    }
+
+    netSetNonBlocking(listenFd, 1);
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+
+    printf("Serving a %ix%i universe on port %i from generation %i\n", config->w, config->h, config->port, generation);
+
+    publishBoard(&export, current, config->w, config->h, config->wrap, 0, generation);
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 period = config->rate > 0 ? frequency / config->rate : 0;
+    Uint64 nextStep = SDL_GetPerformanceCounter();
+    Uint64 nextReport = nextStep + frequency * SERVERREPORT / 1000;
+    int reportGeneration = 0;
+
+    while(!serverQuit && (config->generations == 0 || generation - startGeneration < config->generations))
+    {
+        Uint64 now = SDL_GetPerformanceCounter();
+
+        if(now >= nextStep)
+        {
+            Uint64 trace = traceBegin();
+            stepBoard(gEngine, current, next, config->w, config->h, config->wrap);
+            traceEnd("stepUniverse", trace);
+            generation++;
+
+            Board *swap = current;
+            current = next;
+            next = swap;
+
+            // Never step into a board that is still being written out
+            if(checkpointHolds(next))
+            {
+                next = spare;
+                spare = swap;
+            }
+
+            // The new generation is only read from now on, so it can be
+            // written out as it is while the next ones are stepped
+            if(checkpointDue(generation))
+            {
+                takeCheckpoint(current, config->w, config->h, config->wrap, generation);
+            }
+
+            publishBoard(&export, current, config->w, config->h, config->wrap, 0, generation);
+
+            // Do not try to catch up after a stall, just carry on from now
+            nextStep = nextStep + period > now ? nextStep + period : now;
+        }
+
+        Board *cells = current;
+
+        // Viewers that sent everything queued so far get the latest generation,
+        // the rest keep draining and fold the generations they missed into their next delta
+        for(int i = 0; i < viewerCount; i++)
+        {
+            if(viewers[i].outSent == viewers[i].outSize && viewers[i].generation != generation)
+            {
+                if(!queueDelta(&viewers[i], cells, generation))
+                {
+                    dropViewer(&viewers[i]);
+                    viewers[i--] = viewers[--viewerCount];
+                }
+            }
+        }
+
+        struct pollfd polls[MAXVIEWERS + 1];
+
+        polls[0].fd = listenFd;
+        polls[0].events = POLLIN;
+        for(int i = 0; i < viewerCount; i++)
+        {
+            polls[i + 1].fd = viewers[i].fd;
+            polls[i + 1].events = POLLIN | (viewers[i].outSent < viewers[i].outSize ? POLLOUT : 0);
+        }
+
+        now = SDL_GetPerformanceCounter();
+        int timeout = nextStep > now ? (int)((nextStep - now) * 1000 / frequency) : 0;
+
+        if(poll(polls, viewerCount + 1, timeout) < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        // Walk backwards so dropping a viewer does not disturb the ones left to check
+        for(int i = viewerCount - 1; i >= 0; i--)
+        {
+            short revents = polls[i + 1].revents;
+            char discard[256];
+
+            // Viewers never send anything, so readable means they hung up
+            if((revents & (POLLERR | POLLHUP | POLLNVAL))
+            || ((revents & POLLIN) && recv(viewers[i].fd, discard, sizeof(discard), 0) <= 0))
+            {
+                dropViewer(&viewers[i]);
+                viewers[i] = viewers[--viewerCount];
+                continue;
+            }
+
+            if(revents & POLLOUT)
+            {
+                flushViewer(&viewers[i]);
+            }
+        }
+
+        if(polls[0].revents & POLLIN)
+        {
+            char host[NETHOSTLEN];
+            int fd = netAccept(listenFd, host, NETHOSTLEN);
+
+            if(fd >= 0 && viewerCount == MAXVIEWERS)
+            {
+                printf("Turning away viewer at %s, too many viewers!\n", host);
+                netClose(fd);
+            }
+            else if(fd >= 0)
+            {
+                Viewer *viewer = &viewers[viewerCount];
+                UniverseInfo info = { config->w, config->h, cells->stride };
+
+                // A new viewer has no cells, so its first delta is the whole universe
+                memset(viewer, 0, sizeof(Viewer));
+                viewer->fd = fd;
+                viewer->generation = -1;
+                viewer->shadow = createBoard(config->w, config->h);
+
+                if(viewer->shadow == NULL || !netSendMessage(fd, MSGUNIVERSE, &info, sizeof(info)))
+                {
+                    dropViewer(viewer);
+                }
+                else
+                {
+                    // Keep little more than one generation in flight, so a slow viewer
+                    // skips ahead instead of lagging behind a deep socket buffer
+                    netSetNonBlocking(fd, 1);
+                    netSetSendBuffer(fd, SDL_max(SERVERMINBUFFER, (int)(cells->h * cells->stride * sizeof(Uint64))));
+                    printf("Viewer connected from %s\n", host);
+                    viewerCount++;
+                }
+            }
+        }
+
+        now = SDL_GetPerformanceCounter();
+        if(now >= nextReport)
+        {
+            long skipped = 0;
+
+            for(int i = 0; i < viewerCount; i++)
+            {
+                skipped += viewers[i].skipped;
+            }
+
+            printf("Generation %i: %.1f gen/s, population %li, %i viewers, %li generations skipped\n", generation,
+                   (generation - reportGeneration) * 1000.0 / SERVERREPORT, countBoardCells(cells, config->w, config->h),
+                   viewerCount, skipped);
+
+            reportGeneration = generation;
+            nextReport = now + frequency * SERVERREPORT / 1000;
+        }
+    }
+
+    printf("Server stopped at generation %i\n", generation);
+
+    // Leave a checkpoint of the generation the server stopped at
+    if(config->checkpoints.prefix != NULL)
+    {
+        waitCheckpoint();
+        takeCheckpoint(current, config->w, config->h, config->wrap, generation);
+    }
+
+    for(int i = 0; i < viewerCount; i++)
+    {
+        dropViewer(&viewers[i]);
+    }
+
+    netClose(listenFd);
+    closeExport(&export);
+    closeCheckpoints();
+    freeBoard(current);
+    freeBoard(next);
+    freeBoard(spare);
+
+    return 0;
+}
+
+int queueDelta(Viewer *viewer, Board *cells, int generation)
+{
+    size_t words = (size_t)cells->h * cells->stride;
+
+    // Worst case is one record per changed word
+    size_t capacity = sizeof(NetHeader) + sizeof(DeltaHead) + words * (sizeof(Uint64) + 2 * sizeof(Uint32));
+
+    if(viewer->outCapacity < capacity)
+    {
+        char *out = realloc(viewer->out, capacity);
+        if(out == NULL)
+        {
+            printf("Unable to allocate delta!\n");
+            return 0;
+        }
+
+        viewer->out = out;
+        viewer->outCapacity = capacity;
+    }
+
+    char *out = viewer->out;
+    NetHeader *header = (NetHeader*)out;
+    DeltaHead *head = (DeltaHead*)(header + 1);
+    char *p = (char*)(head + 1);
+    Uint64 *now = cells->cells;
+    Uint64 *had = viewer->shadow->cells;
+    size_t i = 0;
+
+    head->generation = generation;
+    head->skipped = viewer->generation >= 0 ? generation - viewer->generation - 1 : 0;
+
+    // Runs of unchanged words are skipped, runs of changed words are sent as XOR masks
+    while(i < words)
+    {
+        Uint32 skip = 0;
+        Uint32 count = 0;
+
+        while(i < words && now[i] == had[i])
+        {
+            skip++;
+            i++;
+        }
+
+        if(i == words)
+        {
+            break;
+        }
+
+        Uint32 *record = (Uint32*)p;
+        Uint64 *changed = (Uint64*)(record + 2);
+
+        while(i < words && now[i] != had[i])
+        {
+            changed[count++] = now[i] ^ had[i];
+            had[i] = now[i];
+            i++;
+        }
+
+        record[0] = skip;
+        record[1] = count;
+        p = (char*)(changed + count);
+    }
+
+    header->type = MSGDELTA;
+    header->size = (Uint32)(p - (char*)head);
+
+    viewer->outSize = p - out;
+    viewer->outSent = 0;
+    viewer->skipped += head->skipped;
+    viewer->generation = generation;
+
+    flushViewer(viewer);
+
+    return 1;
+}
+
+void flushViewer(Viewer *viewer)
+{
+    while(viewer->outSent < viewer->outSize)
+    {
+        ssize_t sent = send(viewer->fd, viewer->out + viewer->outSent, viewer->outSize - viewer->outSent, 0);
+
+        // A full socket buffer is how a slow viewer shows up, try again later
+        if(sent <= 0)
+        {
+            break;
+        }
+
+        viewer->outSent += sent;
+    }
+}
+
+void dropViewer(Viewer *viewer)
+{
+    if(viewer->shadow != NULL)
+    {
+        printf("Viewer disconnected after skipping %li generations\n", viewer->skipped);
+    }
+
+    netClose(viewer->fd);
+    freeBoard(viewer->shadow);
+    free(viewer->out);
+    viewer->shadow = NULL;
+    viewer->out = NULL;
+}
+
+#else
+
+int runServer(ServerConfig *config)
+{
+    printf("Server mode is not supported on this platform!\n");
+    return 1;
+}
+
+#endif
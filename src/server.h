@@ -0,0 +1,84 @@
+// ###########################################################################
+//          Title: YaGoL Server Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Steps a universe without a window and streams every
+//                 generation to connected viewers as a delta against what
+//                 each viewer already has. Viewers that fall behind skip
+//                 generations instead of slowing the server down.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "engine.h"
+#include "net.h"
+#include "checkpoint.h"
+#include "export.h"
+
+#define MAXVIEWERS 64
+#define SERVERREPORT 5000 // How often the server prints its statistics (ms)
+#define SERVERMINBUFFER (16 * 1024) // Smallest socket send buffer given to a viewer
+
+enum SERVERMESSAGE
+{
+    MSGUNIVERSE = 16, // Server -> viewer: size of the universe, sent once
+    MSGDELTA = 17 // Server -> viewer: changed words since the last delta
+};
+
+typedef struct SERVERCONFIG_S
+{
+    int port;
+    int w;
+    int h;
+    int wrap;
+    Uint64 seed;
+    int rate; // Generations per second, 0 for as fast as possible
+    int generations; // Stop after this many, 0 to run until interrupted
+    CheckpointConfig checkpoints;
+    char *restoreFile; // Checkpoint to start from instead of a seeded universe
+    char *exportName; // Shared memory every generation is published to, or NULL
+    int exportSlots;
+} ServerConfig;
+
+typedef struct UNIVERSEINFO_S
+{
+    Sint32 w;
+    Sint32 h;
+    Sint32 stride; // Words per row, deltas index words with this stride
+} UniverseInfo;
+
+// Followed by records of a Uint32 count of unchanged words to skip, a Uint32
+// count of changed words, and that many words to XOR into the viewer's cells
+typedef struct DELTAHEAD_S
+{
+    Sint32 generation;
+    Sint32 skipped; // Generations folded into this delta because the viewer was behind
+} DeltaHead;
+
+typedef struct VIEWER_S
+{
+    int fd;
+    Board *shadow; // Cells as the viewer has them once its queued data arrives
+    char *out; // Queued message, flushed without blocking
+    size_t outSize;
+    size_t outSent;
+    size_t outCapacity;
+    int generation; // Generation of the last delta queued
+    long skipped;
+} Viewer;
+
+int runServer(ServerConfig *config);
+int queueDelta(Viewer *viewer, Board *cells, int generation);
+void flushViewer(Viewer *viewer);
+void dropViewer(Viewer *viewer);
+
+#endif
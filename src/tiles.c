@@ -0,0 +1,515 @@
+// ###########################################################################
+//          Title: YaGoL Tile Store
+//         Author: Mike Del Pozzo
+//    Description: Keeps a universe as packed tiles in a memory-mapped file
+//                 and steps it a row of tiles at a time, so universes much
+//                 larger than memory can be stepped and resumed later.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "tiles.h"
+#include "workers.h"
+#include "trace.h"
+
+extern Engine *gEngine;
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+volatile sig_atomic_t tilesQuit = 0;
+
+void stopTiles(int signal)
+{
+    tilesQuit = 1;
+}
+
+int runTiles(TileConfig *config)
+{
+    TileStore store;
+
+    if(!openTileStore(&store, config))
+    {
+        return 1;
+    }
+
+    // Every thread stepping tiles gets its own boards for the whole run
+    int scratchCount = workerCount();
+    TileScratch *scratch = createTileScratch(scratchCount);
+    Uint64 *population = malloc(sizeof(Uint64) * store.tilesX);
+    if(scratch == NULL || population == NULL)
+    {
+        printf("Unable to allocate tile boards!\n");
+        freeTileScratch(scratch, scratchCount);
+        free(population);
+        closeTileStore(&store);
+        return 1;
+    }
+
+    // Stop at the end of a generation, the file stays resumable either way
+    signal(SIGINT, stopTiles);
+    signal(SIGTERM, stopTiles);
+
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    Uint64 nextReport = start + frequency * TILEREPORT / 1000;
+    Uint64 alive = 0;
+    int stepped = 0;
+    int result = 0;
+
+    while(stepped < config->generations && !tilesQuit)
+    {
+        // The file keeps the last whole generation when a step fails
+        if(!stepTiles(&store, gEngine, population, scratch, scratchCount, &alive))
+        {
+            printf("Unable to step tiles!\n");
+            result = 1;
+            break;
+        }
+
+        stepped++;
+
+        if(SDL_GetPerformanceCounter() >= nextReport)
+        {
+            nextReport = SDL_GetPerformanceCounter() + frequency * TILEREPORT / 1000;
+            printf("Generation %llu, %llu cells alive\n", (unsigned long long)store.header->generation, (unsigned long long)alive);
+        }
+    }
+
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / frequency;
+
+    printf("Stepped %i generations of a %ix%i universe in %ix%i tiles in %.3f s (%.1f Mcells/s)\n", stepped,
+           store.header->w, store.header->h, store.tilesX, store.tilesY, seconds,
+           (double)store.header->w * store.header->h * stepped / seconds / 1e6);
+    printf("%s holds generation %llu, %llu cells alive\n", config->filename, (unsigned long long)store.header->generation,
+           (unsigned long long)alive);
+
+    if(result == 0 && config->verify && !verifyTiles(&store, gEngine))
+    {
+        result = 1;
+    }
+
+    freeTileScratch(scratch, scratchCount);
+    free(population);
+    closeTileStore(&store);
+
+    return result;
+}
+
+int openTileStore(TileStore *store, TileConfig *config)
+{
+    TileHeader header;
+    struct stat info;
+
+    memset(store, 0, sizeof(TileStore));
+    store->page = (size_t)sysconf(_SC_PAGESIZE);
+
+    store->fd = open(config->filename, O_RDWR | O_CREAT, 0644);
+    if(store->fd < 0 || fstat(store->fd, &info) < 0)
+    {
+        printf("Unable to open tile store %s! %s\n", config->filename, strerror(errno));
+        return 0;
+    }
+
+    int resume = info.st_size > 0;
+
+    if(resume)
+    {
+        if(pread(store->fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.magic, TILEMAGIC, 8) != 0
+        || header.tileSize != TILESIZE)
+        {
+            printf("%s is not a tile store!\n", config->filename);
+            close(store->fd);
+            return 0;
+        }
+    }
+    else
+    {
+        // Universes are whole tiles, so no tile has cells past the edge
+        memset(&header, 0, sizeof(header));
+        header.w = (config->w + TILESIZE - 1) / TILESIZE * TILESIZE;
+        header.h = (config->h + TILESIZE - 1) / TILESIZE * TILESIZE;
+        header.tileSize = TILESIZE;
+        header.wrap = config->wrap;
+        header.seed = config->seed;
+    }
+
+    store->tilesX = header.w / TILESIZE;
+    store->tilesY = header.h / TILESIZE;
+    store->size = TILEHEADERSIZE + 2 * (size_t)store->tilesX * store->tilesY * TILEBYTES;
+
+    // A new file is sparse until it is seeded
+    if((resume && (size_t)info.st_size < store->size) || (!resume && ftruncate(store->fd, (off_t)store->size) < 0))
+    {
+        printf("Unable to size tile store %s!\n", config->filename);
+        close(store->fd);
+        return 0;
+    }
+
+    store->map = mmap(NULL, store->size, PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+    if(store->map == MAP_FAILED)
+    {
+        printf("Unable to map tile store %s! %s\n", config->filename, strerror(errno));
+        close(store->fd);
+        return 0;
+    }
+
+    store->header = (TileHeader*)store->map;
+
+    if(resume)
+    {
+        printf("Resuming a %ix%i universe at generation %llu from %s\n", header.w, header.h,
+               (unsigned long long)header.generation, config->filename);
+        return 1;
+    }
+
+    printf("Seeding a %ix%i universe in %s\n", header.w, header.h, config->filename);
+
+    // The magic goes in last, so a file is only a tile store once it is fully seeded
+    memcpy(store->header, &header, sizeof(header));
+
+    TileJob job = { store, NULL, 0, 0, 0, NULL, NULL, 0, { 0 } };
+
+    for(job.ty = 0; job.ty < store->tilesY; job.ty++)
+    {
+        runWorkers(seedTile, &job, store->tilesX);
+        adviseTiles(store, 0, job.ty, MADV_DONTNEED);
+    }
+
+    memcpy(store->header->magic, TILEMAGIC, 8);
+    msync(store->map, store->size, MS_SYNC);
+
+    return 1;
+}
+
+Uint64* tileRow(TileStore *store, int array, int tx, int ty, int row)
+{
+    // Rows just above and below a tile belong to the tiles next to it
+    if(row < 0)
+    {
+        ty--;
+        row += TILESIZE;
+    }
+    else if(row >= TILESIZE)
+    {
+        ty++;
+        row -= TILESIZE;
+    }
+
+    if(store->header->wrap)
+    {
+        tx = (tx + store->tilesX) % store->tilesX;
+        ty = (ty + store->tilesY) % store->tilesY;
+    }
+    else if(tx < 0 || ty < 0 || tx >= store->tilesX || ty >= store->tilesY)
+    {
+        return NULL;
+    }
+
+    size_t tile = ((size_t)array * store->tilesY + ty) * store->tilesX + tx;
+
+    return (Uint64*)(store->map + TILEHEADERSIZE + tile * TILEBYTES) + (size_t)row * TILEWORDS;
+}
+
+void adviseTiles(TileStore *store, int array, int ty, int advice)
+{
+    if(ty < 0 || ty >= store->tilesY)
+    {
+        return;
+    }
+
+    // A row of tiles is contiguous, widened here to whole pages
+    Uint8 *start = (Uint8*)tileRow(store, array, 0, ty, 0);
+    size_t length = store->tilesX * TILEBYTES;
+    size_t offset = (size_t)(start - store->map) % store->page;
+
+    if(advice == MADV_DONTNEED)
+    {
+        // Start writing changed pages back before they are let go
+        msync(start - offset, length + offset, MS_ASYNC);
+    }
+
+    madvise(start - offset, length + offset, advice);
+}
+
+void seedTile(void *data, int item)
+{
+    TileJob *job = data;
+
+    for(int row = 0; row < TILESIZE; row++)
+    {
+        Uint64 *to = tileRow(job->store, 0, item, job->ty, row);
+
+        for(int i = 0; i < TILEWORDS; i++)
+        {
+            to[i] = seededWord(job->store->header->seed, item * TILEWORDS + i, job->ty * TILESIZE + row);
+        }
+    }
+}
+
+TileScratch* createTileScratch(int count)
+{
+    TileScratch *scratch = calloc(count, sizeof(TileScratch));
+    if(scratch == NULL)
+    {
+        return NULL;
+    }
+
+    // A tile is stepped in a board one word wider on each side and one
+    // row taller, holding the edges of the 8 tiles around it
+    for(int i = 0; i < count; i++)
+    {
+        scratch[i].halo = createBoard(TILESIZE + 128, TILESIZE + 2);
+        scratch[i].next = createBoard(TILESIZE + 128, TILESIZE + 2);
+
+        if(scratch[i].halo == NULL || scratch[i].next == NULL)
+        {
+            freeTileScratch(scratch, count);
+            return NULL;
+        }
+    }
+
+    return scratch;
+}
+
+void freeTileScratch(TileScratch *scratch, int count)
+{
+    if(scratch == NULL)
+    {
+        return;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        freeBoard(scratch[i].halo);
+        freeBoard(scratch[i].next);
+    }
+
+    free(scratch);
+}
+
+void stepTile(void *data, int item)
+{
+    TileJob *job = data;
+    Uint64 start = traceBegin();
+    TileScratch *scratch = NULL;
+
+    // No more tiles are stepped at once than there are threads, so a pair is always free
+    for(int i = 0; i < job->scratchCount && scratch == NULL; i++)
+    {
+        if(SDL_AtomicCAS(&job->scratch[i].busy, 0, 1))
+        {
+            scratch = &job->scratch[i];
+        }
+    }
+
+    if(scratch == NULL)
+    {
+        SDL_AtomicSet(&job->failed, 1);
+        return;
+    }
+
+    Board *halo = scratch->halo;
+    Board *next = scratch->next;
+
+    for(int row = -1; row <= TILESIZE; row++)
+    {
+        Uint64 *to = halo->cells + (size_t)(row + 1) * halo->stride;
+        Uint64 *west = tileRow(job->store, job->src, item - 1, job->ty, row);
+        Uint64 *from = tileRow(job->store, job->src, item, job->ty, row);
+        Uint64 *east = tileRow(job->store, job->src, item + 1, job->ty, row);
+
+        to[0] = west != NULL ? west[TILEWORDS - 1] : 0;
+        to[TILEWORDS + 1] = east != NULL ? east[0] : 0;
+
+        if(from != NULL)
+        {
+            memcpy(to + 1, from, TILEWORDS * sizeof(Uint64));
+        }
+    }
+
+    // Only the tile's own rows are stepped, workers are already busy with the other tiles
+    if(job->engine->stepRows != NULL)
+    {
+        job->engine->stepRows(halo->cells, next->cells, halo->cells + (size_t)halo->h * halo->stride, halo->stride,
+                              halo->w, halo->h, 0, 1, TILESIZE + 1);
+    }
+    else
+    {
+        stepReference(halo, next, halo->w, halo->h, 0);
+    }
+
+    Uint64 alive = 0;
+
+    for(int row = 0; row < TILESIZE; row++)
+    {
+        Uint64 *from = next->cells + (size_t)(row + 1) * next->stride + 1;
+        Uint64 *to = tileRow(job->store, job->dst, item, job->ty, row);
+
+        memcpy(to, from, TILEWORDS * sizeof(Uint64));
+
+        for(int i = 0; i < TILEWORDS; i++)
+        {
+            alive += __builtin_popcountll(from[i]);
+        }
+    }
+
+    job->population[item] = alive;
+
+    SDL_AtomicSet(&scratch->busy, 0);
+
+    traceEnd("stepTile", start);
+}
+
+int stepTiles(TileStore *store, Engine *engine, Uint64 *population, TileScratch *scratch, int scratchCount, Uint64 *alive)
+{
+    TileJob job = { store, engine, store->header->current, store->header->current ^ 1, 0, population, scratch, scratchCount, { 0 } };
+
+    *alive = 0;
+
+    adviseTiles(store, job.src, store->header->wrap ? store->tilesY - 1 : -1, MADV_WILLNEED);
+    adviseTiles(store, job.src, 0, MADV_WILLNEED);
+
+    // Tiles are stepped in file order, a row at a time, so only about three
+    // rows of source tiles and one row of new tiles need to be resident
+    for(job.ty = 0; job.ty < store->tilesY; job.ty++)
+    {
+        adviseTiles(store, job.src, job.ty + 1, MADV_WILLNEED);
+
+        runWorkers(stepTile, &job, store->tilesX);
+
+        for(int i = 0; i < store->tilesX; i++)
+        {
+            *alive += population[i];
+        }
+
+        adviseTiles(store, job.dst, job.ty, MADV_DONTNEED);
+
+        // The first row is read again by the last one when the universe wraps
+        if(job.ty >= 1 && !(store->header->wrap && job.ty == 1))
+        {
+            adviseTiles(store, job.src, job.ty - 1, MADV_DONTNEED);
+        }
+    }
+
+    if(SDL_AtomicGet(&job.failed))
+    {
+        return 0;
+    }
+
+    // Only now does the new generation replace the old one, a run stopped
+    // before this point resumes from the old one. The new tiles have to be
+    // on disk before the header names them, or a crash could leave it
+    // pointing at tiles that were never written
+    syncTiles(store, job.dst);
+    store->header->current = job.dst;
+    store->header->generation++;
+    msync(store->map, store->page, MS_SYNC);
+
+    return 1;
+}
+
+void syncTiles(TileStore *store, int array)
+{
+    // The array is widened to whole pages, as in adviseTiles
+    Uint8 *start = (Uint8*)tileRow(store, array, 0, 0, 0);
+    size_t length = (size_t)store->tilesX * store->tilesY * TILEBYTES;
+    size_t offset = (size_t)(start - store->map) % store->page;
+
+    msync(start - offset, length + offset, MS_SYNC);
+}
+
+int verifyTiles(TileStore *store, Engine *engine)
+{
+    Board *boards[2];
+    int w = store->header->w;
+    int h = store->header->h;
+    long mismatches = 0;
+
+    boards[0] = createBoard(w, h);
+    boards[1] = createBoard(w, h);
+
+    if(boards[0] == NULL || boards[1] == NULL)
+    {
+        freeBoard(boards[0]);
+        freeBoard(boards[1]);
+        return 0;
+    }
+
+    // Step the same universe in memory, it has to come out identical
+    fillBoardSeeded(boards[0], 0, 0, 0, 0, w, h, store->header->seed);
+
+    for(Uint64 i = 0; i < store->header->generation; i++)
+    {
+        stepBoard(engine, boards[i & 1], boards[(i + 1) & 1], w, h, store->header->wrap);
+    }
+
+    Board *board = boards[store->header->generation & 1];
+
+    for(int ty = 0; ty < store->tilesY; ty++)
+    {
+        for(int tx = 0; tx < store->tilesX; tx++)
+        {
+            for(int row = 0; row < TILESIZE; row++)
+            {
+                Uint64 *cells = tileRow(store, store->header->current, tx, ty, row);
+                Uint64 *expected = board->cells + (size_t)(ty * TILESIZE + row) * board->stride + tx * TILEWORDS;
+
+                if(memcmp(cells, expected, TILEWORDS * sizeof(Uint64)) != 0)
+                {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    if(mismatches > 0)
+    {
+        printf("Verify failed, %li tile rows differ from the universe stepped in memory!\n", mismatches);
+    }
+    else
+    {
+        printf("Verified against the universe stepped in memory\n");
+    }
+
+    freeBoard(boards[0]);
+    freeBoard(boards[1]);
+
+    return mismatches == 0;
+}
+
+void closeTileStore(TileStore *store)
+{
+    if(store->map != NULL)
+    {
+        msync(store->map, store->size, MS_SYNC);
+        munmap(store->map, store->size);
+        store->map = NULL;
+    }
+
+    close(store->fd);
+}
+
+#else
+
+// Memory-mapped tile stores are only built on POSIX systems for now
+int runTiles(TileConfig *config)
+{
+    printf("Tile stores are not supported on this platform!\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,99 @@
+// ###########################################################################
+//          Title: YaGoL Tile Store
+//         Author: Mike Del Pozzo
+//    Description: Keeps a universe as packed tiles in a memory-mapped file
+//                 and steps it a row of tiles at a time, so universes much
+//                 larger than memory can be stepped and resumed later.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef TILES_H
+#define TILES_H
+
+#include "engine.h"
+
+#define TILESIZE 512 // Width and height of a tile in cells
+#define TILEWORDS (TILESIZE / 64) // Words in each row of a tile
+#define TILEBYTES ((size_t)TILESIZE * TILEWORDS * sizeof(Uint64))
+#define TILEHEADERSIZE 65536 // Tiles start on a page boundary for pages of up to 64K
+#define TILEMAGIC "YAGOLTS1"
+#define TILEREPORT 5000 // How often progress is printed (ms)
+
+typedef struct TILEHEADER_S
+{
+    char magic[8];
+    Sint32 w; // Universe size in cells, a whole number of tiles
+    Sint32 h;
+    Sint32 tileSize;
+    Sint32 wrap;
+    Sint32 current; // Which of the two tile arrays holds the latest generation
+    Sint32 unused;
+    Uint64 generation; // Generations stepped since the universe was seeded
+    Uint64 seed;
+} TileHeader;
+
+typedef struct TILESTORE_S
+{
+    int fd;
+    Uint8 *map; // The whole file: header, then two arrays of tiles in row order
+    size_t size;
+    TileHeader *header;
+    int tilesX;
+    int tilesY;
+    size_t page;
+} TileStore;
+
+typedef struct TILECONFIG_S
+{
+    char *filename; // Created and seeded if it does not exist, resumed if it does
+    int w; // Universe size in cells, rounded up to whole tiles
+    int h;
+    int generations;
+    int wrap;
+    Uint64 seed; // Initial universe, see fillBoardSeeded
+    int verify; // Also step the universe in memory and compare
+} TileConfig;
+
+// Boards a tile is stepped in, one pair for each thread stepping tiles
+typedef struct TILESCRATCH_S
+{
+    Board *halo;
+    Board *next;
+    SDL_atomic_t busy; // Claimed by the thread stepping a tile in it
+} TileScratch;
+
+typedef struct TILEJOB_S
+{
+    TileStore *store;
+    Engine *engine;
+    int src; // Tile arrays read and written
+    int dst;
+    int ty; // Row of tiles being worked on
+    Uint64 *population; // Live cells of each tile in the row
+    TileScratch *scratch;
+    int scratchCount;
+    SDL_atomic_t failed;
+} TileJob;
+
+int runTiles(TileConfig *config);
+int openTileStore(TileStore *store, TileConfig *config);
+Uint64* tileRow(TileStore *store, int array, int tx, int ty, int row);
+void adviseTiles(TileStore *store, int array, int ty, int advice);
+void seedTile(void *data, int item);
+void stepTile(void *data, int item);
+TileScratch* createTileScratch(int count);
+void freeTileScratch(TileScratch *scratch, int count);
+int stepTiles(TileStore *store, Engine *engine, Uint64 *population, TileScratch *scratch, int scratchCount, Uint64 *alive);
+void syncTiles(TileStore *store, int array);
+int verifyTiles(TileStore *store, Engine *engine);
+void closeTileStore(TileStore *store);
+
+#endif
@@ -0,0 +1,199 @@
+// ###########################################################################
+//          Title: YaGoL Trace Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Records timed trace points into per-thread buffers and
+//                 writes them out as Chrome/Perfetto trace-event JSON.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+int gTraceEnabled = 0; // Trace points cost one branch while this is 0
+
+char *traceFilename = NULL;
+Uint64 traceOrigin = 0; // Performance counter value that the trace timestamps start from
+TraceBuffer *traceBuffers = NULL; // Lock-free list of every thread's buffer
+SDL_atomic_t traceThreads; // Used to hand out thread ids
+
+// Each thread only ever writes to its own buffer
+_Thread_local TraceBuffer *threadBuffer = NULL;
+
+void initTrace(char *filename)
+{
+    traceFilename = filename;
+    traceOrigin = SDL_GetPerformanceCounter();
+    gTraceEnabled = filename != NULL;
+}
+
+TraceBuffer* traceThreadBuffer()
+{
+    if(threadBuffer == NULL)
+    {
+        TraceBuffer *buffer = calloc(1, sizeof(TraceBuffer));
+        if(buffer == NULL)
+        {
+            return NULL;
+        }
+
+        buffer->tid = SDL_AtomicAdd(&traceThreads, 1) + 1;
+        snprintf(buffer->threadName, sizeof(buffer->threadName), "thread %i", buffer->tid);
+
+        // Push onto the list without a lock, the writer may run concurrently
+        do
+        {
+            buffer->next = traceBuffers;
+        } while(!SDL_AtomicCASPtr((void**)&traceBuffers, buffer->next, buffer));
+
+        threadBuffer = buffer;
+    }
+
+    return threadBuffer;
+}
+
+void traceThreadName(const char *name)
+{
+    if(!gTraceEnabled)
+    {
+        return;
+    }
+
+    TraceBuffer *buffer = traceThreadBuffer();
+    if(buffer != NULL)
+    {
+        snprintf(buffer->threadName, sizeof(buffer->threadName), "%s", name);
+    }
+}
+
+Uint64 traceBegin()
+{
+    return gTraceEnabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+void traceEnd(const char *name, Uint64 start)
+{
+    if(start == 0)
+    {
+        return;
+    }
+
+    Uint64 end = SDL_GetPerformanceCounter();
+    TraceBuffer *buffer = traceThreadBuffer();
+    if(buffer == NULL)
+    {
+        return;
+    }
+
+    // The buffer is a ring, so a dump always holds the most recent events
+    Uint32 count = (Uint32)SDL_AtomicGet(&buffer->count);
+    TraceEvent *event = &buffer->events[count & (TRACEEVENTS - 1)];
+
+    event->name = name;
+    event->start = start;
+    event->end = end;
+
+    // Publish the event only after it is fully written
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&buffer->count, (int)(count + 1));
+}
+
+int writeTrace()
+{
+    if(!gTraceEnabled)
+    {
+        return 0;
+    }
+
+    FILE *file = fopen(traceFilename, "w");
+    if(file == NULL)
+    {
+        printf("Unable to write trace file %s!\n", traceFilename);
+        return 0;
+    }
+
+    double scale = 1000000.0 / SDL_GetPerformanceFrequency();
+    int first = 1;
+    int events = 0;
+    int wrapped = 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for(TraceBuffer *buffer = SDL_AtomicGetPtr((void**)&traceBuffers); buffer != NULL; buffer = buffer->next)
+    {
+        // Only read events the owning thread has already published, oldest first
+        Uint32 count = (Uint32)SDL_AtomicGet(&buffer->count);
+        int wrappedBuffer = count > TRACEEVENTS;
+        Uint32 oldest = wrappedBuffer ? count - TRACEEVENTS : 0;
+        SDL_MemoryBarrierAcquire();
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", buffer->tid, buffer->threadName);
+        first = 0;
+
+        for(Uint32 i = oldest; i != count; i++)
+        {
+            TraceEvent event = buffer->events[i & (TRACEEVENTS - 1)];
+
+            // Skip an event the owning thread overwrote, or may be overwriting as
+            // its next slot, while it was copied
+            SDL_MemoryBarrierAcquire();
+            if((Uint32)SDL_AtomicGet(&buffer->count) - i >= TRACEEVENTS)
+            {
+                continue;
+            }
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+                event.name, buffer->tid, (event.start - traceOrigin) * scale, (event.end - event.start) * scale);
+            events++;
+        }
+
+        if(wrappedBuffer)
+        {
+            printf("Trace buffer for %s wrapped, only its last %i events are kept\n", buffer->threadName, TRACEEVENTS);
+            wrapped = 1;
+        }
+    }
+
+    fprintf(file, "\n]");
+
+    // Say in the dump itself when it does not go back to the start of the run
+    if(wrapped)
+    {
+        fprintf(file, ",\"otherData\":{\"note\":\"Earlier events were dropped, each thread keeps its last %i events\"}", TRACEEVENTS);
+    }
+
+    fprintf(file, "}\n");
+    fclose(file);
+
+    printf("Wrote %i trace events to %s\n", events, traceFilename);
+
+    return 1;
+}
+
+void closeTrace()
+{
+    writeTrace();
+    gTraceEnabled = 0;
+
+    // Buffers are only freed here, after every traced thread has stopped
+    TraceBuffer *buffer = traceBuffers;
+    while(buffer != NULL)
+    {
+        TraceBuffer *next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+
+    traceBuffers = NULL;
+    threadBuffer = NULL;
+}
@@ -0,0 +1,50 @@
+// ###########################################################################
+//          Title: YaGoL Trace Subsystem
+//         Author: Mike Del Pozzo
+//    Description: Records timed trace points into per-thread buffers and
+//                 writes them out as Chrome/Perfetto trace-event JSON.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL2/SDL.h>
+
+#define TRACEEVENTS 65536 // Events kept per thread, a power of two. Once full the oldest are overwritten
+
+typedef struct TRACEEVENT_S
+{
+    const char *name; // Must point to a string that outlives the trace
+    Uint64 start; // Performance counter values
+    Uint64 end;
+} TraceEvent;
+
+typedef struct TRACEBUFFER_S
+{
+    TraceEvent events[TRACEEVENTS];
+    SDL_atomic_t count; // Events ever published by the owning thread, the next one goes in count % TRACEEVENTS
+    int tid;
+    char threadName[32];
+    struct TRACEBUFFER_S *next;
+} TraceBuffer;
+
+extern int gTraceEnabled;
+
+void initTrace(char *filename);
+TraceBuffer* traceThreadBuffer();
+void traceThreadName(const char *name);
+Uint64 traceBegin();
+void traceEnd(const char *name, Uint64 start);
+int writeTrace();
+void closeTrace();
+
+#endif
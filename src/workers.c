@@ -0,0 +1,208 @@
+// ###########################################################################
+//          Title: YaGoL Worker Subsystem
+//         Author: Mike Del Pozzo
+//    Description: A small pool of worker threads that split loops such as
+//                 stepping the grid into chunks and run them in parallel.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include "workers.h"
+#include "trace.h"
+
+int gActiveThreads = 1; // Threads that took part in the last job, including the caller
+
+SDL_Thread *workerThreads[MAXWORKERS];
+int workerThreadCount = 0;
+
+SDL_mutex *workerLock = NULL;
+SDL_cond *workerWake = NULL; // Signalled when a new job is posted
+SDL_cond *workerIdle = NULL; // Signalled when a job is finished
+WorkerJob *workerJob = NULL;
+int workerGeneration = 0; // Bumped for every job so sleeping workers can tell it is new
+int workerQuit = 0;
+int workersInside = 0; // Workers still holding a pointer to the current job
+SDL_atomic_t workersJoined; // Workers that picked up at least one item of the current job
+
+void doWork(WorkerJob *job, int *joined)
+{
+    int item;
+
+    // Items are handed out one at a time so uneven items still balance
+    while((item = SDL_AtomicAdd(&job->next, 1)) < job->items)
+    {
+        if(joined != NULL && !*joined)
+        {
+            *joined = 1;
+            SDL_AtomicAdd(&workersJoined, 1);
+        }
+
+        job->fn(job->data, item);
+
+        if(SDL_AtomicAdd(&job->done, 1) + 1 == job->items)
+        {
+            SDL_LockMutex(workerLock);
+            SDL_CondSignal(workerIdle);
+            SDL_UnlockMutex(workerLock);
+        }
+    }
+}
+
+int workerMain(void *data)
+{
+    int seen = 0;
+    char name[32];
+
+    snprintf(name, sizeof(name), "worker %i", (int)(intptr_t)data);
+    traceThreadName(name);
+
+    SDL_LockMutex(workerLock);
+    while(!workerQuit)
+    {
+        if(workerGeneration == seen || workerJob == NULL)
+        {
+            SDL_CondWait(workerWake, workerLock);
+            continue;
+        }
+
+        seen = workerGeneration;
+        WorkerJob *job = workerJob;
+        workersInside++;
+        SDL_UnlockMutex(workerLock);
+
+        int joined = 0;
+        Uint64 trace = traceBegin();
+        doWork(job, &joined);
+        traceEnd("worker", trace);
+
+        // The job lives on the caller's stack, so let it know we are done with it
+        SDL_LockMutex(workerLock);
+        workersInside--;
+        SDL_CondSignal(workerIdle);
+    }
+    SDL_UnlockMutex(workerLock);
+
+    return 0;
+}
+
+int initWorkers(int count)
+{
+    if(count < 1)
+    {
+        count = SDL_GetCPUCount();
+    }
+
+    if(count > MAXWORKERS)
+    {
+        count = MAXWORKERS;
+    }
+
+    workerLock = SDL_CreateMutex();
+    workerWake = SDL_CreateCond();
+    workerIdle = SDL_CreateCond();
+    if(workerLock == NULL || workerWake == NULL || workerIdle == NULL)
+    {
+        printf("Unable to create worker locks! SDL Error: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    // A pool may be started again after closeWorkers, so forget the last one
+    workerQuit = 0;
+    workerGeneration = 0;
+    workerJob = NULL;
+    workersInside = 0;
+
+    // The calling thread always works too, so start one fewer thread
+    for(int i = 1; i < count; i++)
+    {
+        workerThreads[workerThreadCount] = SDL_CreateThread(workerMain, "worker", (void*)(intptr_t)i);
+        if(workerThreads[workerThreadCount] == NULL)
+        {
+            printf("Unable to create worker thread! SDL Error: %s\n", SDL_GetError());
+            break;
+        }
+        workerThreadCount++;
+    }
+
+    return 1;
+}
+
+void runWorkers(WorkFn fn, void *data, int items)
+{
+    WorkerJob job;
+
+    job.fn = fn;
+    job.data = data;
+    job.items = items;
+    SDL_AtomicSet(&job.next, 0);
+    SDL_AtomicSet(&job.done, 0);
+
+    // Small jobs are not worth waking anybody up for
+    if(workerThreadCount == 0 || items < 2)
+    {
+        for(int i = 0; i < items; i++)
+        {
+            fn(data, i);
+        }
+        gActiveThreads = 1;
+        return;
+    }
+
+    SDL_AtomicSet(&workersJoined, 0);
+
+    SDL_LockMutex(workerLock);
+    workerJob = &job;
+    workerGeneration++;
+    SDL_CondBroadcast(workerWake);
+    SDL_UnlockMutex(workerLock);
+
+    doWork(&job, NULL);
+
+    SDL_LockMutex(workerLock);
+    while(SDL_AtomicGet(&job.done) < items || workersInside > 0)
+    {
+        SDL_CondWait(workerIdle, workerLock);
+    }
+    workerJob = NULL;
+    SDL_UnlockMutex(workerLock);
+
+    gActiveThreads = 1 + SDL_AtomicGet(&workersJoined);
+}
+
+int workerCount()
+{
+    return workerThreadCount + 1;
+}
+
+void closeWorkers()
+{
+    if(workerLock == NULL)
+    {
+        return;
+    }
+
+    SDL_LockMutex(workerLock);
+    workerQuit = 1;
+    SDL_CondBroadcast(workerWake);
+    SDL_UnlockMutex(workerLock);
+
+    for(int i = 0; i < workerThreadCount; i++)
+    {
+        SDL_WaitThread(workerThreads[i], NULL);
+    }
+    workerThreadCount = 0;
+
+    SDL_DestroyCond(workerIdle);
+    SDL_DestroyCond(workerWake);
+    SDL_DestroyMutex(workerLock);
+    workerIdle = NULL;
+    workerWake = NULL;
+    workerLock = NULL;
+}
@@ -0,0 +1,40 @@
+// ###########################################################################
+//          Title: YaGoL Worker Subsystem
+//         Author: Mike Del Pozzo
+//    Description: A small pool of worker threads that split loops such as
+//                 stepping the grid into chunks and run them in parallel.
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <SDL2/SDL.h>
+
+#define MAXWORKERS 64
+
+typedef void (*WorkFn)(void *data, int item);
+
+typedef struct WORKERJOB_S
+{
+    WorkFn fn;
+    void *data;
+    int items; // fn is called once for each item in [0, items)
+    SDL_atomic_t next; // Next item to hand out
+    SDL_atomic_t done; // Items finished
+} WorkerJob;
+
+int initWorkers(int count);
+void runWorkers(WorkFn fn, void *data, int items);
+int workerCount();
+void closeWorkers();
+
+#endif
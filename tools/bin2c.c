@@ -0,0 +1,57 @@
+// ###########################################################################
+//          Title: YaGoL bin2c
+//         Author: Mike Del Pozzo
+//    Description: Build tool that writes the given files out as C arrays
+//                 so they can be embedded in the YaGoL executable.
+//                 Usage: bin2c file... > embedded.c
+//        Version: 1.0.1
+//           Date: 23 July 2023
+//        License: GPLv3 (see LICENSE)
+//
+//    YaGoL Copyright (C) 2023 Mike Del Pozzo
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    any later version.
+// ###########################################################################
+
+#include <stdio.h>
+
+int main(int argc, char * argv[])
+{
+    printf("// Generated by tools/bin2c.c, do not edit\n\n");
+    printf("#include \"assets.h\"\n\n");
+
+    for(int i = 1; i < argc; i++)
+    {
+        FILE *file = fopen(argv[i], "rb");
+        if(file == NULL)
+        {
+            fprintf(stderr, "bin2c: unable to open %s\n", argv[i]);
+            return 1;
+        }
+
+        printf("static const unsigned char asset%i[] =\n{", i);
+
+        int c;
+        int n = 0;
+        while((c = fgetc(file)) != EOF)
+        {
+            printf("%s0x%02x,", n % 16 == 0 ? "\n    " : " ", c);
+            n++;
+        }
+
+        printf("\n};\n\n");
+        fclose(file);
+    }
+
+    printf("const Asset EmbeddedAssets[] =\n{\n");
+    for(int i = 1; i < argc; i++)
+    {
+        printf("    { \"%s\", asset%i, sizeof(asset%i) },\n", argv[i], i, i);
+    }
+    printf("    { NULL, NULL, 0 }\n};\n\n");
+    printf("const int embeddedAssetCount = %i;\n", argc - 1);
+
+    return 0;
+}